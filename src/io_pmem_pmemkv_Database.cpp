@@ -30,9 +30,35 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include <jni.h>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+#include "io_pmem_pmemkv_Database.h"
 #include <libpmemkv.h>
 #include <libpmemkv_json_config.h>
 #include <iostream>
@@ -42,669 +68,5139 @@
 
 #define EXCEPTION_CLASS "io/pmem/pmemkv/DatabaseException"
 
-extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1start
-        (JNIEnv* env, jobject obj, jstring engine, jstring config) {
-    const char* cengine = env->GetStringUTFChars(engine, NULL);
-    const char* cconfig = env->GetStringUTFChars(config, NULL);
-
-    auto cfg = pmemkv_config_new();
-    if (config == nullptr) {
-        env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
-        return 0;
-    }
-
-    auto status = pmemkv_config_from_json(cfg, cconfig);
-    if (status != PMEMKV_STATUS_OK) {
-        pmemkv_config_delete(cfg);
-        env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
-        return 0;
-    }
-
-    pmemkv_db *db;
-    status = pmemkv_open(cengine, cfg, &db);
-
-    env->ReleaseStringUTFChars(engine, cengine);
-    env->ReleaseStringUTFChars(config, cconfig);
-
-    if (status != PMEMKV_STATUS_OK)
-        env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
-
-    return (jlong) db;
-}
-
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1stop
-        (JNIEnv* env, jobject obj, jlong pointer) {
-    auto engine = (pmemkv_db*) pointer;
-    pmemkv_close(engine);
-}
-
-struct Context {
-    JNIEnv* env;
-    jobject callback;
-    jmethodID mid;
-};
-
-#define CONTEXT {env, callback, mid}
-
 #define METHOD_GET_KEYS_BUFFER "(ILjava/nio/ByteBuffer;)V"
 #define METHOD_GET_KEYS_BYTEARRAY "([B)V"
 #define METHOD_GET_KEYS_STRING "(Ljava/lang/String;)V"
 #define METHOD_GET_ALL_BUFFER "(ILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;)V"
 #define METHOD_GET_ALL_BYTEARRAY "([B[B)V"
 #define METHOD_GET_ALL_STRING "(Ljava/lang/String;Ljava/lang/String;)V"
+#define METHOD_GET_ALL_BATCH "(II)V"
+#define METHOD_GET_BORROWED "(Ljava/nio/ByteBuffer;)V"
 
-struct ContextGetKeysBuffer {
-    JNIEnv* env;
-    jobject callback;
+/*
+ * Classes and callback method IDs are resolved once in JNI_OnLoad. A callback
+ * object which does not implement the expected interface falls back to a
+ * per-call method lookup.
+ */
+struct CallbackMethod {
+    const char* classname;
+    const char* signature;
+    jclass cls;
     jmethodID mid;
-    int keybytes;
-    char* key;
-    jobject keybuf;
 };
 
-#define CONTEXT_GET_KEYS_BUFFER {env, callback, mid, 0, nullptr, nullptr}
+static CallbackMethod GET_KEYS_BUFFER_METHOD = {"io/pmem/pmemkv/internal/AllBuffersJNICallback", METHOD_GET_KEYS_BUFFER, nullptr, nullptr};
+static CallbackMethod GET_KEYS_BYTEARRAY_METHOD = {"io/pmem/pmemkv/AllByteArraysCallback", METHOD_GET_KEYS_BYTEARRAY, nullptr, nullptr};
+static CallbackMethod GET_KEYS_STRING_METHOD = {"io/pmem/pmemkv/AllStringsCallback", METHOD_GET_KEYS_STRING, nullptr, nullptr};
+static CallbackMethod GET_ALL_BUFFER_METHOD = {"io/pmem/pmemkv/internal/GetAllBufferJNICallback", METHOD_GET_ALL_BUFFER, nullptr, nullptr};
+static CallbackMethod GET_ALL_BYTEARRAY_METHOD = {"io/pmem/pmemkv/GetAllByteArrayCallback", METHOD_GET_ALL_BYTEARRAY, nullptr, nullptr};
+static CallbackMethod GET_ALL_STRING_METHOD = {"io/pmem/pmemkv/GetAllStringCallback", METHOD_GET_ALL_STRING, nullptr, nullptr};
+static CallbackMethod GET_ALL_BATCH_METHOD = {"io/pmem/pmemkv/internal/GetAllBatchJNICallback", METHOD_GET_ALL_BATCH, nullptr, nullptr};
+static CallbackMethod GET_BORROWED_METHOD = {"io/pmem/pmemkv/internal/BorrowedValueJNICallback", METHOD_GET_BORROWED, nullptr, nullptr};
 
-const auto CALLBACK_GET_KEYS_BUFFER = [](const char* k, size_t kb, const char* v, size_t vb, void *arg) -> int {
-    const auto c = ((ContextGetKeysBuffer*) arg);
-    if (kb > c->keybytes) {
-        if (c->keybuf != nullptr) c->env->DeleteLocalRef(c->keybuf);
-        c->keybytes = kb;
-        c->key = new char[kb];
-        c->keybuf = c->env->NewDirectByteBuffer(c->key, kb);
-    }
-    std::memcpy(c->key, k, kb);
-    c->env->CallVoidMethod(c->callback, c->mid, kb, c->keybuf);
-    return 0;
+static CallbackMethod* const CALLBACK_METHODS[] = {
+    &GET_KEYS_BUFFER_METHOD, &GET_KEYS_BYTEARRAY_METHOD, &GET_KEYS_STRING_METHOD,
+    &GET_ALL_BUFFER_METHOD, &GET_ALL_BYTEARRAY_METHOD, &GET_ALL_STRING_METHOD,
+    &GET_ALL_BATCH_METHOD, &GET_BORROWED_METHOD,
 };
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1buffer
-        (JNIEnv* env, jobject obj, jlong pointer, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_KEYS_BUFFER);
-    ContextGetKeysBuffer cxt = CONTEXT_GET_KEYS_BUFFER;
-    auto status = pmemkv_get_all(engine, CALLBACK_GET_KEYS_BUFFER, &cxt);
-    if (cxt.keybuf != nullptr) env->DeleteLocalRef(cxt.keybuf);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
+static JavaVM* jvm = nullptr;
+static jclass exception_class = nullptr;
+static jmethodID buffer_as_read_only = nullptr;
+static jmethodID buffer_limit = nullptr;
+
+static jclass global_class(JNIEnv* env, const char* name) {
+    const auto cls = env->FindClass(name);
+    if (cls == nullptr) {
+        env->ExceptionClear();
+        return nullptr;
+    }
+    const auto global = (jclass) env->NewGlobalRef(cls);
+    env->DeleteLocalRef(cls);
+    return global;
 }
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1buffer
-        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const char* ckey = (char*) env->GetDirectBufferAddress(key);
+static jmethodID callback_method(JNIEnv* env, jobject callback, const CallbackMethod& method) {
+    if (method.mid != nullptr && env->IsInstanceOf(callback, method.cls))
+        return method.mid;
     const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_KEYS_BUFFER);
-    ContextGetKeysBuffer cxt = CONTEXT_GET_KEYS_BUFFER;
-    auto status = pmemkv_get_above(engine, ckey, keybytes, CALLBACK_GET_KEYS_BUFFER, &cxt);
-    if (cxt.keybuf != nullptr) env->DeleteLocalRef(cxt.keybuf);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
+    const auto mid = env->GetMethodID(cls, "process", method.signature);
+    env->DeleteLocalRef(cls);
+    return mid;
 }
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1buffer
-        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const char* ckey = (char*) env->GetDirectBufferAddress(key);
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_KEYS_BUFFER);
-    ContextGetKeysBuffer cxt = CONTEXT_GET_KEYS_BUFFER;
-    auto status = pmemkv_get_below(engine, ckey, keybytes, CALLBACK_GET_KEYS_BUFFER, &cxt);
-    if (cxt.keybuf != nullptr) env->DeleteLocalRef(cxt.keybuf);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
+static void throw_exception(JNIEnv* env, const char* message) {
+    if (env->ExceptionCheck()) return;
+    if (exception_class != nullptr) {
+        env->ThrowNew(exception_class, message);
+        return;
+    }
+    const auto cls = env->FindClass(EXCEPTION_CLASS);
+    if (cls != nullptr) env->ThrowNew(cls, message);
 }
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1buffer
-        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes1, jobject key1, jint keybytes2, jobject key2, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const char* ckey1 = (char*) env->GetDirectBufferAddress(key1);
-    const char* ckey2 = (char*) env->GetDirectBufferAddress(key2);
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_KEYS_BUFFER);
-    ContextGetKeysBuffer cxt = CONTEXT_GET_KEYS_BUFFER;
-    auto status = pmemkv_get_between(engine, ckey1, keybytes1, ckey2, keybytes2, CALLBACK_GET_KEYS_BUFFER, &cxt);
-    if (cxt.keybuf != nullptr) env->DeleteLocalRef(cxt.keybuf);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
+/*
+ * Returns the address of the direct ByteBuffer 'buffer' after checking that
+ * its capacity covers 'bytes'. Throws and returns nullptr otherwise,
+ * including for heap buffers, whose capacity JNI reports as -1.
+ */
+static char* direct_buffer(JNIEnv* env, jobject buffer, jlong bytes) {
+    const auto address = (char*) env->GetDirectBufferAddress(buffer);
+    if (address == nullptr || bytes < 0) {
+        throw_exception(env, "Invalid ByteBuffer");
+        return nullptr;
+    }
+    if (bytes > env->GetDirectBufferCapacity(buffer)) {
+        throw_exception(env, "ByteBuffer is too small");
+        return nullptr;
+    }
+    return address;
 }
 
-const auto CALLBACK_GET_KEYS_BYTEARRAY = [](const char* k, size_t kb, const char* v, size_t vb, void *arg) -> int {
-    const auto c = ((Context*) arg);
-    const auto ckey = c->env->NewByteArray(kb);
-    c->env->SetByteArrayRegion(ckey, 0, kb, (jbyte*) k);
-    c->env->CallVoidMethod(c->callback, c->mid, ckey);
-    c->env->DeleteLocalRef(ckey);
-    return 0;
-};
+/*
+ * Builds a java.lang.String from exactly 'bytes' bytes of UTF-8 (keys and
+ * values are not NUL-terminated and may contain NULs). ASCII input, the
+ * common case, is detected 16 or 8 bytes at a time and widened directly;
+ * anything else goes through a UTF-8 decoder which replaces malformed
+ * sequences with U+FFFD. The UTF-16 buffer is per-thread and reused.
+ * Decoding never yields more UTF-16 units than there are input bytes, so
+ * bounding the input to a jsize also bounds the length given to NewString.
+ */
+static thread_local std::vector<jchar> string_chars;
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1bytes
-        (JNIEnv* env, jobject obj, jlong pointer, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_KEYS_BYTEARRAY);
-    Context cxt = CONTEXT;
-    auto status = pmemkv_get_all(engine, CALLBACK_GET_KEYS_BYTEARRAY, &cxt);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
+static inline bool is_ascii(const char* data, size_t bytes) {
+    size_t i = 0;
+#ifdef __SSE2__
+    for (; i + 16 <= bytes; i += 16) {
+        const auto chunk = _mm_loadu_si128((const __m128i*) (data + i));
+        if (_mm_movemask_epi8(chunk) != 0) return false;
+    }
+#endif
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        if (word & 0x8080808080808080ULL) return false;
+    }
+    for (; i < bytes; i++)
+        if (data[i] & 0x80) return false;
+    return true;
 }
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1bytes
-        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto ckey = env->GetByteArrayElements(key, NULL);
-    const auto ckeybytes = env->GetArrayLength(key);
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_KEYS_BYTEARRAY);
-    Context cxt = CONTEXT;
-    auto status = pmemkv_get_above(engine, (char *) ckey, ckeybytes, CALLBACK_GET_KEYS_BYTEARRAY, &cxt);
-    env->ReleaseByteArrayElements(key, ckey, JNI_ABORT);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
-}
+static size_t decode_utf8(const char* data, size_t bytes, jchar* out) {
+    const auto in = (const uint8_t*) data;
+    size_t length = 0;
+    size_t i = 0;
+    while (i < bytes) {
+        const uint32_t lead = in[i];
+        uint32_t cp;
+        size_t n;
+        uint32_t min;
+        if (lead < 0x80) {
+            out[length++] = lead;
+            i++;
+            continue;
+        } else if ((lead & 0xE0) == 0xC0) {
+            cp = lead & 0x1F; n = 1; min = 0x80;
+        } else if ((lead & 0xF0) == 0xE0) {
+            cp = lead & 0x0F; n = 2; min = 0x800;
+        } else if ((lead & 0xF8) == 0xF0) {
+            cp = lead & 0x07; n = 3; min = 0x10000;
+        } else {
+            out[length++] = 0xFFFD;
+            i++;
+            continue;
+        }
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1bytes
-        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto ckey = env->GetByteArrayElements(key, NULL);
-    const auto ckeybytes = env->GetArrayLength(key);
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_KEYS_BYTEARRAY);
-    Context cxt = CONTEXT;
-    auto status = pmemkv_get_below(engine, (char*) ckey, ckeybytes, CALLBACK_GET_KEYS_BYTEARRAY, &cxt);
-    env->ReleaseByteArrayElements(key, ckey, JNI_ABORT);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
+        size_t j = 1;
+        for (; j <= n && i + j < bytes && (in[i + j] & 0xC0) == 0x80; j++)
+            cp = (cp << 6) | (in[i + j] & 0x3F);
+        if (j <= n || cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+            out[length++] = 0xFFFD;
+            i += j;
+            continue;
+        }
+        if (cp >= 0x10000) {
+            cp -= 0x10000;
+            out[length++] = 0xD800 + (cp >> 10);
+            out[length++] = 0xDC00 + (cp & 0x3FF);
+        } else {
+            out[length++] = cp;
+        }
+        i += n + 1;
+    }
+    return length;
 }
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1bytes
-        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key1, jbyteArray key2, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto ckey1 = env->GetByteArrayElements(key1, NULL);
-    const auto ckeybytes1 = env->GetArrayLength(key1);
-    const auto ckey2 = env->GetByteArrayElements(key2, NULL);
-    const auto ckeybytes2 = env->GetArrayLength(key2);
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_KEYS_BYTEARRAY);
-    Context cxt = CONTEXT;
-    auto status = pmemkv_get_between(engine, (char*) ckey1, ckeybytes1, (char*) ckey2, ckeybytes2, CALLBACK_GET_KEYS_BYTEARRAY, &cxt);
-    env->ReleaseByteArrayElements(key1, ckey1, JNI_ABORT);
-    env->ReleaseByteArrayElements(key2, ckey2, JNI_ABORT);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
+static jstring new_string(JNIEnv* env, const char* data, size_t bytes) {
+    if (bytes > (size_t) INT32_MAX) {
+        throw_exception(env, "Value is too large for a Java string");
+        return NULL;
+    }
+    if (string_chars.size() < bytes) string_chars.resize(bytes);
+    const auto chars = string_chars.data();
+    size_t length = bytes;
+    if (is_ascii(data, bytes)) {
+        for (size_t i = 0; i < bytes; i++) chars[i] = (uint8_t) data[i];
+    } else {
+        length = decode_utf8(data, bytes, chars);
+    }
+    return env->NewString(chars, length);
 }
 
-const auto CALLBACK_GET_KEYS_STRING = [](const char* k, size_t kb, const char* v, size_t vb, void *arg) -> int {
-    const auto c = ((Context*) arg);
-    const auto ckey = c->env->NewStringUTF(k);
-    c->env->CallVoidMethod(c->callback, c->mid, ckey);
-    c->env->DeleteLocalRef(ckey);
-    return 0;
-};
+#define BYTE_ARRAY_STACK_BYTES 256
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1string
-        (JNIEnv* env, jobject obj, jlong pointer, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_KEYS_STRING);
-    Context cxt = CONTEXT;
-    auto status = pmemkv_get_all(engine, CALLBACK_GET_KEYS_STRING, &cxt);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
-}
+/*
+ * Read-only copy of a byte[] argument, taken with GetByteArrayRegion: on the
+ * stack for arrays up to BYTE_ARRAY_STACK_BYTES, on the heap otherwise, or
+ * through GetByteArrayElements if the heap copy cannot be allocated. Arrays
+ * are never pinned with GetPrimitiveArrayCritical, as every user goes on to
+ * call the engine or wait for a cache or stripe lock, neither of which is
+ * allowed inside a critical region.
+ */
+class ByteArray {
+public:
+    ByteArray(JNIEnv* env, jbyteArray array) : env(env), array(array), length(env->GetArrayLength(array)) {
+        if (length <= BYTE_ARRAY_STACK_BYTES) {
+            env->GetByteArrayRegion(array, 0, length, (jbyte*) local);
+            return;
+        }
+        heap.reset(new (std::nothrow) char[length]);
+        if (heap != nullptr)
+            env->GetByteArrayRegion(array, 0, length, (jbyte*) heap.get());
+        else
+            elements = (char*) env->GetByteArrayElements(array, NULL);
+    }
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1string
-        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto ckey = env->GetByteArrayElements(key, NULL);
-    const auto ckeybytes = env->GetArrayLength(key);
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_KEYS_STRING);
-    Context cxt = CONTEXT;
-    auto status = pmemkv_get_above(engine, (char*) ckey, ckeybytes, CALLBACK_GET_KEYS_STRING, &cxt);
-    env->ReleaseByteArrayElements(key, ckey, JNI_ABORT);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
-}
+    ~ByteArray() {
+        if (elements != nullptr) env->ReleaseByteArrayElements(array, (jbyte*) elements, JNI_ABORT);
+    }
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1string
-        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto ckey = env->GetByteArrayElements(key, NULL);
-    const auto ckeybytes = env->GetArrayLength(key);
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_KEYS_STRING);
-    Context cxt = CONTEXT;
-    auto status = pmemkv_get_below(engine, (char*) ckey, ckeybytes, CALLBACK_GET_KEYS_STRING, &cxt);
-    env->ReleaseByteArrayElements(key, ckey, JNI_ABORT);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
-}
+    ByteArray(const ByteArray&) = delete;
+    ByteArray& operator=(const ByteArray&) = delete;
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1string
-        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key1, jbyteArray key2, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto ckey1 = env->GetByteArrayElements(key1, NULL);
-    const auto ckeybytes1 = env->GetArrayLength(key1);
-    const auto ckey2 = env->GetByteArrayElements(key2, NULL);
-    const auto ckeybytes2 = env->GetArrayLength(key2);
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_KEYS_STRING);
-    Context cxt = CONTEXT;
-    auto status = pmemkv_get_between(engine, (char*) ckey1, ckeybytes1, (char*) ckey2, ckeybytes2, CALLBACK_GET_KEYS_STRING, &cxt);
-    env->ReleaseByteArrayElements(key1, ckey1, JNI_ABORT);
-    env->ReleaseByteArrayElements(key2, ckey2, JNI_ABORT);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
-}
+    const char* data() const {
+        if (length <= BYTE_ARRAY_STACK_BYTES) return local;
+        return heap != nullptr ? heap.get() : elements;
+    }
 
-extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1count_1all
-        (JNIEnv* env, jobject obj, jlong pointer) {
-    auto engine = (pmemkv_db*) pointer;
-    size_t count;
-    pmemkv_count_all(engine, &count);
+    jsize size() const {
+        return length;
+    }
 
-    return count;
-}
+private:
+    JNIEnv* env;
+    jbyteArray array;
+    jsize length;
+    std::unique_ptr<char[]> heap;
+    char* elements = nullptr;
+    char local[BYTE_ARRAY_STACK_BYTES];
+};
 
-extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1count_1above_1buffer
-        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key) {
-    auto engine = (pmemkv_db*) pointer;
-    const char* ckey = (char*) env->GetDirectBufferAddress(key);
-    
-    size_t count;
-    pmemkv_count_above(engine, ckey, keybytes, &count);
+#define SCRATCH_MIN_BYTES 64
 
-    return count;
+/*
+ * Scans hand keys and values to Java through direct ByteBuffers backed by
+ * per-thread scratch memory. Buffers grow geometrically and are reused by
+ * later scans on the same thread; each nesting level (a scan started from
+ * within a scan callback) gets its own pair.
+ *
+ * Every arena is registered, and database_stop releases all of them except
+ * those in use by a scan, which their owning thread holds locked. A thread
+ * that exits while detached from the JVM cannot delete its global refs, so
+ * it leaves its buffers in 'scratch_orphans' for the next database_stop.
+ */
+struct ScratchBuffer {
+    char* data;
+    size_t capacity;
+    jobject buffer;
+};
+
+struct ScratchLevel {
+    ScratchBuffer key;
+    ScratchBuffer value;
+};
+
+static void scratch_free(JNIEnv* env, ScratchBuffer& b) {
+    if (b.buffer != nullptr && env != nullptr) env->DeleteGlobalRef(b.buffer);
+    delete[] b.data;
+    b = {nullptr, 0, nullptr};
 }
 
-extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1count_1below_1buffer
-        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key) {
-    auto engine = (pmemkv_db*) pointer;
-    const char* ckey = (char*) env->GetDirectBufferAddress(key);
+struct ScratchArena;
 
-    size_t count;
-    pmemkv_count_below(engine, ckey, keybytes, &count);
+static std::mutex scratch_registry_lock;
+static std::vector<ScratchArena*> scratch_arenas;
+static std::vector<ScratchBuffer> scratch_orphans;
 
-    return count;
-}
+struct ScratchArena {
+    std::vector<std::unique_ptr<ScratchLevel>> levels;
+    size_t depth = 0;
+    // held by the owning thread while depth > 0
+    std::mutex lock;
 
-extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1count_1between_1buffer
-        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes1, jobject key1, jint keybytes2, jobject key2) {
-    auto engine = (pmemkv_db*) pointer;
-    const char* ckey1 = (char*) env->GetDirectBufferAddress(key1);
-    const char* ckey2 = (char*) env->GetDirectBufferAddress(key2);
-    
-    size_t count;
-    pmemkv_count_between(engine, ckey1, keybytes1, ckey2, keybytes2, &count);
+    ScratchArena() {
+        std::lock_guard<std::mutex> guard(scratch_registry_lock);
+        scratch_arenas.push_back(this);
+    }
 
-    return count;
-}
+    void release(JNIEnv* env, size_t from) {
+        for (size_t i = from; i < levels.size(); i++) {
+            scratch_free(env, levels[i]->key);
+            scratch_free(env, levels[i]->value);
+        }
+        levels.resize(from);
+    }
 
-extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1count_1above_1bytes
-        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto ckey = env->GetByteArrayElements(key, NULL);
-    const auto ckeybytes = env->GetArrayLength(key);
-        
-    size_t count;
-    pmemkv_count_above(engine, (char *)ckey, ckeybytes, &count);
+    ~ScratchArena() {
+        JNIEnv* env = nullptr;
+        if (jvm == nullptr || jvm->GetEnv((void**) &env, JNI_VERSION_1_6) != JNI_OK) env = nullptr;
+        std::lock_guard<std::mutex> guard(scratch_registry_lock);
+        scratch_arenas.erase(std::find(scratch_arenas.begin(), scratch_arenas.end(), this));
+        if (env == nullptr) {
+            for (auto& level : levels) {
+                for (auto b : {&level->key, &level->value}) {
+                    if (b->buffer == nullptr) continue;
+                    scratch_orphans.push_back(*b);
+                    *b = {nullptr, 0, nullptr};
+                }
+            }
+        }
+        release(env, 0);
+    }
+};
 
-    env->ReleaseByteArrayElements(key, ckey, JNI_ABORT);
+static thread_local ScratchArena scratch_arena;
 
-    return count;
-}
+class ScratchScope {
+public:
+    ScratchScope() {
+        if (scratch_arena.depth == 0) scratch_arena.lock.lock();
+        if (scratch_arena.levels.size() == scratch_arena.depth)
+            scratch_arena.levels.emplace_back(new ScratchLevel());
+        level = scratch_arena.levels[scratch_arena.depth++].get();
+    }
 
-extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1count_1below_1bytes
-        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto ckey = env->GetByteArrayElements(key, NULL);
-    const auto ckeybytes = env->GetArrayLength(key);
+    ~ScratchScope() {
+        if (--scratch_arena.depth == 0) scratch_arena.lock.unlock();
+    }
 
-    size_t count;
-    pmemkv_count_below(engine, (char*) ckey, ckeybytes, &count);
+    ScratchLevel* level;
+};
+
+/*
+ * Releases the orphaned buffers and every idle arena. The calling thread
+ * keeps the levels of the scans it is running, if it stops a database from
+ * within a scan callback.
+ */
+static void scratch_release_all(JNIEnv* env) {
+    auto& own = scratch_arena;
+    std::lock_guard<std::mutex> guard(scratch_registry_lock);
+    for (auto& b : scratch_orphans) scratch_free(env, b);
+    scratch_orphans.clear();
+    for (auto arena : scratch_arenas) {
+        if (arena == &own) continue;
+        std::unique_lock<std::mutex> idle(arena->lock, std::try_to_lock);
+        if (idle.owns_lock()) arena->release(env, 0);
+    }
+    if (own.depth > 0) {
+        own.release(env, own.depth);
+    } else {
+        std::lock_guard<std::mutex> idle(own.lock);
+        own.release(env, 0);
+    }
+}
 
-    env->ReleaseByteArrayElements(key, ckey, JNI_ABORT);
+static bool scratch_reserve(JNIEnv* env, ScratchBuffer& b, size_t bytes) {
+    if (bytes <= b.capacity) return true;
+    size_t capacity = b.capacity > 0 ? b.capacity : SCRATCH_MIN_BYTES;
+    while (capacity < bytes) capacity *= 2;
 
-    return count;
+    char* data = new (std::nothrow) char[capacity];
+    if (data == nullptr) {
+        throw_exception(env, "Cannot allocate scratch buffer");
+        return false;
+    }
+    const auto local = env->NewDirectByteBuffer(data, capacity);
+    const auto global = local != nullptr ? env->NewGlobalRef(local) : nullptr;
+    if (local != nullptr) env->DeleteLocalRef(local);
+    if (global == nullptr) {
+        delete[] data;
+        return false;
+    }
+    scratch_free(env, b);
+    b = {data, capacity, global};
+    return true;
 }
 
-extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1count_1between_1bytes
-        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key1, jbyteArray key2) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto ckey1 = env->GetByteArrayElements(key1, NULL);
-    const auto ckeybytes1 = env->GetArrayLength(key1);
-    const auto ckey2 = env->GetByteArrayElements(key2, NULL);
-    const auto ckeybytes2 = env->GetArrayLength(key2);
+/*
+ * Latency and byte counters for every entry point. Each thread records into
+ * its own block, written only by that thread with relaxed stores, and
+ * database_stats merges all blocks on demand. Blocks of exited threads are
+ * kept, with their counts, and handed to the next new thread.
+ *
+ * Histograms are log-linear: values below 8 ns get their own bucket, above
+ * that each power of two is split into 8 sub-buckets, so any percentile is
+ * within 12.5% of the recorded value. "Engine" time is spent inside pmemkv
+ * calls, including the scan callbacks they invoke; the rest of the total
+ * is JNI overhead.
+ */
+#define STATS_OPS(X) \
+    X(GET_BUFFER, "get_buffer") \
+    X(GET_BYTES, "get_bytes") \
+    X(GET_INTO_BYTES, "get_into_bytes") \
+    X(GET_MANY_BUFFER, "get_many_buffer") \
+    X(GET_BORROWED_BUFFER, "get_borrowed_buffer") \
+    X(EXISTS_BUFFER, "exists_buffer") \
+    X(EXISTS_BYTES, "exists_bytes") \
+    X(PUT_BUFFER, "put_buffer") \
+    X(PUT_BYTES, "put_bytes") \
+    X(WRITE_BATCH, "write_batch") \
+    X(REMOVE_BUFFER, "remove_buffer") \
+    X(REMOVE_BYTES, "remove_bytes") \
+    X(COUNT_ALL, "count_all") \
+    X(COUNT_BUFFER, "count_buffer") \
+    X(COUNT_BYTES, "count_bytes") \
+    X(SCAN_KEYS_BUFFER, "scan_keys_buffer") \
+    X(SCAN_KEYS_BYTES, "scan_keys_bytes") \
+    X(SCAN_KEYS_STRING, "scan_keys_string") \
+    X(SCAN_BUFFER, "scan_buffer") \
+    X(SCAN_BYTES, "scan_bytes") \
+    X(SCAN_STRING, "scan_string") \
+    X(SCAN_BATCH, "scan_batch") \
+    X(SCAN_PARALLEL, "scan_parallel") \
+    X(CURSOR_NEXT, "cursor_next") \
+    X(SNAPSHOT_EXPORT, "snapshot_export") \
+    X(SNAPSHOT_IMPORT, "snapshot_import") \
+    X(BULK_LOAD, "bulk_load") \
+    X(GET_LONG, "get_long") \
+    X(PUT_LONG, "put_long") \
+    X(REMOVE_LONG, "remove_long") \
+    X(GET_LONGS, "get_longs") \
+    X(PUT_LONGS, "put_longs") \
+    X(REMOVE_LONGS, "remove_longs") \
+    X(INCREMENT, "increment") \
+    X(COMPARE_AND_SET, "compare_and_set") \
+    X(PUT_IF_ABSENT, "put_if_absent") \
+    X(ASYNC_GET, "async_get") \
+    X(ASYNC_PUT, "async_put") \
+    X(ASYNC_REMOVE, "async_remove") \
+    X(ASYNC_SCAN, "async_scan")
 
-    size_t count;
-    pmemkv_count_between(engine, (char*) ckey1, ckeybytes1, (char*) ckey2, ckeybytes2, &count);
+#define STATS_OP_ENUM(op, name) STATS_##op,
+#define STATS_OP_NAME(op, name) name,
+enum { STATS_OPS(STATS_OP_ENUM) STATS_OP_COUNT };
+static const char* const STATS_OP_NAMES[] = { STATS_OPS(STATS_OP_NAME) };
 
-    env->ReleaseByteArrayElements(key1, ckey1, JNI_ABORT);
-    env->ReleaseByteArrayElements(key2, ckey2, JNI_ABORT);
-    return count;
-}
+#define STATS_SUB_BITS 3
+#define STATS_MAX_EXPONENT 40
+#define STATS_BUCKETS ((STATS_MAX_EXPONENT - STATS_SUB_BITS + 2) << STATS_SUB_BITS)
 
-struct ContextGetAllBuffer {
-    JNIEnv* env;
-    jobject callback;
-    jmethodID mid;
-    int keybytes;
-    char* key;
-    jobject keybuf;
-    int valuebytes;
-    char* value;
-    jobject valuebuf;
+struct OpStats {
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> bytes;
+    std::atomic<uint64_t> total[STATS_BUCKETS];
+    std::atomic<uint64_t> engine[STATS_BUCKETS];
+};
+
+struct ThreadStats {
+    OpStats ops[STATS_OP_COUNT];
 };
 
-#define CONTEXT_GET_ALL_BUFFER {env, callback, mid, 0, nullptr, nullptr, 0, nullptr, nullptr}
+static std::mutex stats_lock;
+static std::vector<ThreadStats*> stats_blocks;
+static std::vector<ThreadStats*> stats_free;
 
-const auto CALLBACK_GET_ALL_BUFFER = [](const char* k, size_t kb, const char* v, size_t vb, void *arg) -> int {
-    const auto c = ((ContextGetAllBuffer*) arg);
-    if (kb > c->keybytes) {
-        if (c->keybuf != nullptr) c->env->DeleteLocalRef(c->keybuf);
-        c->keybytes = kb;
-        c->key = new char[kb];
-        c->keybuf = c->env->NewDirectByteBuffer(c->key, kb);
+struct ThreadStatsHandle {
+    ThreadStats* stats = nullptr;
+
+    ThreadStats* get() {
+        if (stats != nullptr) return stats;
+        std::lock_guard<std::mutex> guard(stats_lock);
+        if (!stats_free.empty()) {
+            stats = stats_free.back();
+            stats_free.pop_back();
+        } else {
+            stats = new ThreadStats();
+            stats_blocks.push_back(stats);
+        }
+        return stats;
+    }
+
+    ~ThreadStatsHandle() {
+        if (stats == nullptr) return;
+        std::lock_guard<std::mutex> guard(stats_lock);
+        stats_free.push_back(stats);
     }
-    if (vb > c->valuebytes) {
-        if (c->valuebuf != nullptr) c->env->DeleteLocalRef(c->valuebuf);
-        c->valuebytes = vb;
-        c->value = new char[vb];
-        c->valuebuf = c->env->NewDirectByteBuffer(c->value, vb);
-    }
-    std::memcpy(c->key, k, kb);
-    std::memcpy(c->value, v, vb);
-    c->env->CallVoidMethod(c->callback, c->mid, kb, c->keybuf, vb, c->valuebuf);
-    return 0;
 };
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1buffer
-        (JNIEnv* env, jobject obj, jlong pointer, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_ALL_BUFFER);
-    ContextGetAllBuffer cxt = CONTEXT_GET_ALL_BUFFER;
-    auto status = pmemkv_get_all(engine, CALLBACK_GET_ALL_BUFFER, &cxt);
-    if (cxt.keybuf != nullptr) env->DeleteLocalRef(cxt.keybuf);
-    if (cxt.valuebuf != nullptr) env->DeleteLocalRef(cxt.valuebuf);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
-}
+static thread_local ThreadStatsHandle thread_stats;
+static thread_local uint64_t thread_engine_ns;
+static thread_local uint64_t thread_engine_calls;
+static thread_local uint64_t thread_op_bytes;
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1buffer
-        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const char* ckey = (char*) env->GetDirectBufferAddress(key);
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_ALL_BUFFER);
-    ContextGetAllBuffer cxt = CONTEXT_GET_ALL_BUFFER;
-    auto status = pmemkv_get_above(engine, ckey, keybytes, CALLBACK_GET_ALL_BUFFER, &cxt);
-    if (cxt.keybuf != nullptr) env->DeleteLocalRef(cxt.keybuf);
-    if (cxt.valuebuf != nullptr) env->DeleteLocalRef(cxt.valuebuf);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
+static inline uint64_t stats_clock() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1buffer
-        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const char* ckey = (char*) env->GetDirectBufferAddress(key);
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_ALL_BUFFER);
-    ContextGetAllBuffer cxt = CONTEXT_GET_ALL_BUFFER;
-    auto status = pmemkv_get_below(engine, ckey, keybytes, CALLBACK_GET_ALL_BUFFER,&cxt);
-    if (cxt.keybuf != nullptr) env->DeleteLocalRef(cxt.keybuf);
-    if (cxt.valuebuf != nullptr) env->DeleteLocalRef(cxt.valuebuf);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
+static inline size_t stats_bucket(uint64_t ns) {
+    if (ns < (1 << STATS_SUB_BITS)) return ns;
+    const int exponent = std::min(63 - __builtin_clzll(ns), STATS_MAX_EXPONENT);
+    const uint64_t sub = (std::min(ns, (uint64_t) (1ULL << (STATS_MAX_EXPONENT + 1)) - 1) >> (exponent - STATS_SUB_BITS)) &
+            ((1 << STATS_SUB_BITS) - 1);
+    return ((exponent - STATS_SUB_BITS + 1) << STATS_SUB_BITS) + sub;
 }
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1buffer
-        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes1, jobject key1, jint keybytes2, jobject key2, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const char* ckey1 = (char*) env->GetDirectBufferAddress(key1);
-    const char* ckey2 = (char*) env->GetDirectBufferAddress(key2);
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_ALL_BUFFER);
-    ContextGetAllBuffer cxt = CONTEXT_GET_ALL_BUFFER;
-    auto status = pmemkv_get_between(engine, ckey1, keybytes1, ckey2, keybytes2, CALLBACK_GET_ALL_BUFFER, &cxt);
-    if (cxt.keybuf != nullptr) env->DeleteLocalRef(cxt.keybuf);
-    if (cxt.valuebuf != nullptr) env->DeleteLocalRef(cxt.valuebuf);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
+/* Upper bound of the values counted in a bucket. */
+static inline uint64_t stats_bucket_value(size_t bucket) {
+    if (bucket < (1 << STATS_SUB_BITS)) return bucket;
+    const int exponent = (bucket >> STATS_SUB_BITS) + STATS_SUB_BITS - 1;
+    const uint64_t sub = bucket & ((1 << STATS_SUB_BITS) - 1);
+    return (1ULL << exponent) + ((sub + 1) << (exponent - STATS_SUB_BITS)) - 1;
 }
 
-const auto CALLBACK_GET_ALL_BYTEARRAY = [](const char* k, size_t kb, const char* v, size_t vb, void *arg) -> int {
-    const auto c = ((Context*) arg);
-    const auto ckey = c->env->NewByteArray(kb);
-    c->env->SetByteArrayRegion(ckey, 0, kb, (jbyte*) k);
-    const auto cvalue = c->env->NewByteArray(vb);
-    c->env->SetByteArrayRegion(cvalue, 0, vb, (jbyte*) v);
-    c->env->CallVoidMethod(c->callback, c->mid, ckey, cvalue);
-    c->env->DeleteLocalRef(ckey);
-    c->env->DeleteLocalRef(cvalue);
-    return 0;
-};
-
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1bytes
-        (JNIEnv* env, jobject obj, jlong pointer, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_ALL_BYTEARRAY);
-    Context cxt = CONTEXT;
-    auto status = pmemkv_get_all(engine, CALLBACK_GET_ALL_BYTEARRAY, &cxt);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
+// only the owning thread writes, so no read-modify-write is needed
+static inline void stats_add(std::atomic<uint64_t>& counter, uint64_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
 }
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1bytes
-        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto ckey = env->GetByteArrayElements(key, NULL);
-    const auto ckeybytes = env->GetArrayLength(key);
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_ALL_BYTEARRAY);
-    Context cxt = CONTEXT;
-    auto status = pmemkv_get_above(engine, (char*) ckey, ckeybytes, CALLBACK_GET_ALL_BYTEARRAY, &cxt);
-    env->ReleaseByteArrayElements(key, ckey, JNI_ABORT);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
+static inline void stats_bytes(size_t bytes) {
+    thread_op_bytes += bytes;
 }
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1bytes
-        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto ckey = env->GetByteArrayElements(key, NULL);
-    const auto ckeybytes = env->GetArrayLength(key);
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_ALL_BYTEARRAY);
+/*
+ * Times one entry point, from construction to the end of the scope. Timers
+ * nest: an inner one counts its own engine time and bytes, which are then
+ * added to those of the enclosing one.
+ */
+class OpTimer {
+public:
+    explicit OpTimer(int op) : op(op), start(stats_clock()),
+            outer_engine_ns(thread_engine_ns), outer_op_bytes(thread_op_bytes) {
+        thread_engine_ns = 0;
+        thread_op_bytes = 0;
+    }
+
+    ~OpTimer() {
+        const uint64_t total = stats_clock() - start;
+        auto& s = thread_stats.get()->ops[op];
+        stats_add(s.count, 1);
+        stats_add(s.bytes, thread_op_bytes);
+        stats_add(s.total[stats_bucket(total)], 1);
+        stats_add(s.engine[stats_bucket(std::min(thread_engine_ns, total))], 1);
+        thread_engine_ns += outer_engine_ns;
+        thread_op_bytes += outer_op_bytes;
+    }
+
+private:
+    int op;
+    uint64_t start;
+    uint64_t outer_engine_ns;
+    uint64_t outer_op_bytes;
+};
+
+/*
+ * Calls into the engine, adding the time spent to the current OpTimer. When
+ * the function times its own engine calls only those are counted, so the
+ * work it does around them is not taken for engine time.
+ */
+template <typename... Params, typename... Args>
+static inline int timed(int (*function)(Params...), Args... args) {
+    const auto calls = thread_engine_calls;
+    const auto start = stats_clock();
+    const auto status = function(args...);
+    if (thread_engine_calls == calls) {
+        thread_engine_ns += stats_clock() - start;
+        thread_engine_calls++;
+    }
+    return status;
+}
+
+static inline uint64_t hash_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static inline uint64_t hash_key(const char* k, size_t kb, uint64_t seed = 0) {
+    uint64_t h = seed ^ (kb * 0x9E3779B97F4A7C15ULL);
+    size_t i = 0;
+    for (; i + 8 <= kb; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, k + i, sizeof(word));
+        h = (h ^ hash_mix(word)) * 0x9E3779B97F4A7C15ULL;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, k + i, kb - i);
+    return hash_mix(h ^ tail);
+}
+
+#define CACHE_DEFAULT_SHARDS 64
+#define CACHE_ENTRY_OVERHEAD 64
+
+/*
+ * Optional DRAM read cache, enabled with the "jni_cache_bytes" config entry
+ * (and optionally "jni_cache_shards"). It is split into shards, each with
+ * its own lock, CLOCK eviction and a share of the byte budget. Every write
+ * made through this library invalidates the key after updating the engine.
+ * A shard's version changes on every invalidation, and a value read from the
+ * engine is only inserted if the version did not change in the meantime, so
+ * a racing write can never leave a stale entry behind.
+ */
+class ReadCache {
+public:
+    ReadCache(size_t bytes, size_t shards) : shards(shards) {
+        shard_bytes = bytes / shards;
+        for (size_t i = 0; i < shards; i++) this->shard[i].hand = this->shard[i].ring.end();
+    }
+
+    /*
+     * The callback runs after the shard lock is released, so it may call
+     * into Java or back into the cache. The value it sees is kept alive by
+     * its own reference even if the entry is evicted meanwhile.
+     */
+    bool get(const char* k, size_t kb, pmemkv_get_v_callback* callback, void* arg) {
+        auto& s = shard_of(k, kb);
+        std::shared_ptr<const std::string> value;
+        {
+            std::lock_guard<std::mutex> guard(s.lock);
+            const auto it = s.index.find(std::string(k, kb));
+            if (it == s.index.end()) {
+                misses++;
+                return false;
+            }
+            hits++;
+            it->second->referenced = true;
+            value = it->second->value;
+        }
+        callback(value->data(), value->size(), arg);
+        return true;
+    }
+
+    uint64_t version(const char* k, size_t kb) {
+        auto& s = shard_of(k, kb);
+        std::lock_guard<std::mutex> guard(s.lock);
+        return s.version;
+    }
+
+    void insert(const char* k, size_t kb, const char* v, size_t vb, uint64_t version) {
+        const size_t bytes = kb + vb + CACHE_ENTRY_OVERHEAD;
+        if (bytes > shard_bytes / 8) return;
+        auto& s = shard_of(k, kb);
+        std::lock_guard<std::mutex> guard(s.lock);
+        if (s.version != version) return;
+        std::string key(k, kb);
+        if (s.index.find(key) != s.index.end()) return;
+        while (s.bytes + bytes > shard_bytes && !s.ring.empty()) {
+            if (s.hand == s.ring.end()) s.hand = s.ring.begin();
+            if (s.hand->referenced) {
+                s.hand->referenced = false;
+                ++s.hand;
+            } else {
+                s.bytes -= s.hand->key.size() + s.hand->value->size() + CACHE_ENTRY_OVERHEAD;
+                s.index.erase(s.hand->key);
+                s.hand = s.ring.erase(s.hand);
+                evictions++;
+            }
+        }
+        const auto entry = s.ring.insert(s.hand, CacheEntry{key, std::make_shared<const std::string>(v, vb), false});
+        s.index.emplace(std::move(key), entry);
+        s.bytes += bytes;
+    }
+
+    void invalidate(const char* k, size_t kb) {
+        auto& s = shard_of(k, kb);
+        std::lock_guard<std::mutex> guard(s.lock);
+        s.version++;
+        const auto it = s.index.find(std::string(k, kb));
+        if (it == s.index.end()) return;
+        if (s.hand == it->second) ++s.hand;
+        s.bytes -= it->second->key.size() + it->second->value->size() + CACHE_ENTRY_OVERHEAD;
+        s.ring.erase(it->second);
+        s.index.erase(it);
+    }
+
+    void stats(jlong* result) {
+        size_t entries = 0, bytes = 0;
+        for (size_t i = 0; i < shards; i++) {
+            std::lock_guard<std::mutex> guard(shard[i].lock);
+            entries += shard[i].index.size();
+            bytes += shard[i].bytes;
+        }
+        result[0] = hits;
+        result[1] = misses;
+        result[2] = evictions;
+        result[3] = entries;
+        result[4] = bytes;
+    }
+
+private:
+    struct CacheEntry {
+        std::string key;
+        std::shared_ptr<const std::string> value;
+        bool referenced;
+    };
+
+    struct Shard {
+        std::mutex lock;
+        std::list<CacheEntry> ring;
+        std::list<CacheEntry>::iterator hand;
+        std::unordered_map<std::string, std::list<CacheEntry>::iterator> index;
+        size_t bytes = 0;
+        uint64_t version = 0;
+    };
+
+    Shard& shard_of(const char* k, size_t kb) {
+        return shard[hash_key(k, kb) % shards];
+    }
+
+    size_t shards;
+    size_t shard_bytes;
+    std::unique_ptr<Shard[]> shard{new Shard[shards]};
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
+};
+
+#define BLOOM_BLOCK_WORDS 8
+#define BLOOM_BLOCK_BITS (BLOOM_BLOCK_WORDS * 64)
+#define BLOOM_MIN_KEYS 1024
+#define BLOOM_DEFAULT_BITS_PER_KEY 10
+#define BLOOM_SIDECAR_MAGIC 0x314D4F4F4C424B50ULL
+
+/*
+ * Blocked Bloom filter: a key only ever touches one 64-byte block, so a
+ * lookup costs a single cache miss. Bits are only ever set, with relaxed
+ * atomics, so lookups and inserts need no lock. Removed keys stay in the
+ * filter until the next rebuild.
+ */
+class BloomFilter {
+public:
+    BloomFilter(size_t keys, size_t bits_per_key) {
+        const size_t bits = std::max(keys, (size_t) BLOOM_MIN_KEYS) * bits_per_key * 3 / 2;
+        size_t hashes = (bits_per_key * 69 + 50) / 100;
+        allocate((bits + BLOOM_BLOCK_BITS - 1) / BLOOM_BLOCK_BITS,
+                std::min(std::max(hashes, (size_t) 1), (size_t) 16));
+    }
+
+    BloomFilter(size_t blocks, size_t hashes, bool) {
+        allocate(blocks, hashes);
+    }
+
+    bool may_contain(const char* k, size_t kb) const {
+        uint64_t h = hash_key(k, kb);
+        const auto block = this->block(h);
+        for (size_t i = 0; i < hashes; i++, h += (h >> 32) | 1) {
+            const auto bit = (h >> 23) % BLOOM_BLOCK_BITS;
+            if (!(block[bit / 64].load(std::memory_order_relaxed) & (1ULL << (bit % 64)))) return false;
+        }
+        return true;
+    }
+
+    void insert(const char* k, size_t kb) {
+        uint64_t h = hash_key(k, kb);
+        const auto block = this->block(h);
+        for (size_t i = 0; i < hashes; i++, h += (h >> 32) | 1) {
+            const auto bit = (h >> 23) % BLOOM_BLOCK_BITS;
+            block[bit / 64].fetch_or(1ULL << (bit % 64), std::memory_order_relaxed);
+        }
+    }
+
+    size_t bits_set() const {
+        size_t set = 0;
+        for (size_t i = 0; i < blocks * BLOOM_BLOCK_WORDS; i++)
+            set += __builtin_popcountll(words[i].load(std::memory_order_relaxed));
+        return set;
+    }
+
+    /* Expected false positive rate, from the fraction of bits set. */
+    double estimated_rate() const {
+        const double fill = (double) bits_set() / bits();
+        double rate = 1;
+        for (size_t i = 0; i < hashes; i++) rate *= fill;
+        return rate;
+    }
+
+    size_t bits() const {
+        return blocks * BLOOM_BLOCK_BITS;
+    }
+
+    /*
+     * Sidecar layout: magic, blocks, hashes, key count of the engine when
+     * saved, then the raw words. All fields are native-endian uint64.
+     */
+    bool save(const std::string& path, uint64_t count) const {
+        FILE* file = fopen(path.c_str(), "wb");
+        if (file == nullptr) return false;
+        const uint64_t header[] = {BLOOM_SIDECAR_MAGIC, blocks, hashes, count};
+        bool ok = fwrite(header, sizeof(header), 1, file) == 1;
+        for (size_t i = 0; ok && i < blocks * BLOOM_BLOCK_WORDS; i++) {
+            const uint64_t word = words[i].load(std::memory_order_relaxed);
+            ok = fwrite(&word, sizeof(word), 1, file) == 1;
+        }
+        return fclose(file) == 0 && ok;
+    }
+
+    /*
+     * Returns nullptr, so the caller rebuilds, unless the sidecar is intact:
+     * the block count is taken from the header only when the file is
+     * exactly that long, so a damaged header cannot size the allocation.
+     */
+    static BloomFilter* load(const std::string& path, uint64_t count) {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (file == nullptr) return nullptr;
+        uint64_t header[4];
+        long length = -1;
+        if (fseek(file, 0, SEEK_END) == 0) length = ftell(file);
+        std::unique_ptr<BloomFilter> filter;
+        const uint64_t block_bytes = BLOOM_BLOCK_WORDS * sizeof(uint64_t);
+        if (length >= (long) sizeof(header) && fseek(file, 0, SEEK_SET) == 0 &&
+                fread(header, sizeof(header), 1, file) == 1 && header[0] == BLOOM_SIDECAR_MAGIC &&
+                header[1] > 0 && header[1] == (length - sizeof(header)) / block_bytes &&
+                (length - sizeof(header)) % block_bytes == 0 &&
+                header[2] > 0 && header[2] <= 16 && header[3] == count) {
+            try {
+                filter.reset(new BloomFilter(header[1], header[2], true));
+                std::vector<uint64_t> words(header[1] * BLOOM_BLOCK_WORDS);
+                if (fread(words.data(), sizeof(uint64_t), words.size(), file) == words.size()) {
+                    for (size_t i = 0; i < words.size(); i++)
+                        filter->words[i].store(words[i], std::memory_order_relaxed);
+                } else {
+                    filter.reset();
+                }
+            } catch (const std::bad_alloc&) {
+                filter.reset();
+            }
+        }
+        fclose(file);
+        return filter.release();
+    }
+
+private:
+    void allocate(size_t blocks, size_t hashes) {
+        this->blocks = blocks;
+        this->hashes = hashes;
+        // over-allocate by one cache line, C++11 new does not honour alignas
+        storage.reset(new std::atomic<uint64_t>[blocks * BLOOM_BLOCK_WORDS + BLOOM_BLOCK_WORDS]);
+        words = storage.get() + (BLOOM_BLOCK_WORDS - ((uintptr_t) storage.get() / 8) % BLOOM_BLOCK_WORDS) %
+                BLOOM_BLOCK_WORDS;
+        for (size_t i = 0; i < blocks * BLOOM_BLOCK_WORDS; i++) words[i].store(0, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t>* block(uint64_t h) const {
+        return words + (h % blocks) * BLOOM_BLOCK_WORDS;
+    }
+
+    size_t blocks;
+    size_t hashes;
+    std::unique_ptr<std::atomic<uint64_t>[]> storage;
+    std::atomic<uint64_t>* words;
+};
+
+const auto CALLBACK_BLOOM_INSERT = [](const char* k, size_t kb, const char* v, size_t vb, void *arg) -> int {
+    ((BloomFilter*) arg)->insert(k, kb);
+    return 0;
+};
+
+struct ContextCacheFill {
+    ReadCache* cache;
+    const char* key;
+    size_t keybytes;
+    uint64_t version;
+    pmemkv_get_v_callback* callback;
+    void* arg;
+};
+
+const auto CALLBACK_CACHE_FILL = [](const char* v, size_t vb, void *arg) {
+    const auto c = ((ContextCacheFill*) arg);
+    c->cache->insert(c->key, c->keybytes, v, vb, c->version);
+    c->callback(v, vb, c->arg);
+};
+
+static inline void store_le32(char* p, uint32_t value) {
+    for (int i = 0; i < 4; i++, value >>= 8) p[i] = (char) (value & 0xFF);
+}
+
+static inline uint32_t load_le32(const char* p) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; i--) value = (value << 8) | (uint8_t) p[i];
+    return value;
+}
+
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 65535
+#define LZ_MAX_HASH_BITS 12
+
+static inline uint32_t lz_read32(const char* p) {
+    uint32_t result;
+    std::memcpy(&result, p, sizeof(result));
+    return result;
+}
+
+static inline void lz_put_length(char*& op, size_t length) {
+    for (; length >= 255; length -= 255) *op++ = (char) 255;
+    *op++ = (char) length;
+}
+
+/*
+ * Appends one sequence: literals, then a match of 'match' bytes at
+ * 'offset' back, or no match for the last sequence. Returns false if it
+ * might not fit before 'op_end'.
+ */
+static bool lz_emit(char*& op, const char* op_end, const char* literals, size_t literalbytes, size_t offset,
+                    size_t match) {
+    if ((size_t) (op_end - op) < 5 + literalbytes + literalbytes / 255 + match / 255) return false;
+    const size_t match_code = match > 0 ? match - LZ_MIN_MATCH : 0;
+    *op++ = (char) ((std::min(literalbytes, (size_t) 15) << 4) | std::min(match_code, (size_t) 15));
+    if (literalbytes >= 15) lz_put_length(op, literalbytes - 15);
+    std::memcpy(op, literals, literalbytes);
+    op += literalbytes;
+    if (match == 0) return true;
+    *op++ = (char) (offset & 0xFF);
+    *op++ = (char) (offset >> 8);
+    if (match_code >= 15) lz_put_length(op, match_code - 15);
+    return true;
+}
+
+/*
+ * Greedy LZ77 in the LZ4 sequence layout: a token with 4-bit literal and
+ * match lengths (15 continues in 255-chained bytes), the literals, and a
+ * 16-bit little-endian offset; the last sequence has literals only.
+ * Returns the compressed size, or 0 if it would not fit in 'capacity'.
+ */
+static size_t lz_compress(const char* src, size_t n, char* dst, size_t capacity) {
+    uint32_t table[1 << LZ_MAX_HASH_BITS];
+    unsigned bits = 6;
+    while (bits < LZ_MAX_HASH_BITS && ((size_t) 1 << bits) < n) bits++;
+    std::memset(table, 0, sizeof(uint32_t) << bits);
+
+    const char* ip = src;
+    const char* anchor = src;
+    const char* end = src + n;
+    char* op = dst;
+    const char* op_end = dst + capacity;
+    while (end - ip >= LZ_MIN_MATCH) {
+        const auto sequence = lz_read32(ip);
+        const auto h = (sequence * 2654435761U) >> (32 - bits);
+        const char* ref = src + table[h];
+        table[h] = (uint32_t) (ip - src);
+        if (ref >= ip || ip - ref > LZ_MAX_OFFSET || lz_read32(ref) != sequence) {
+            ip++;
+            continue;
+        }
+        size_t match = LZ_MIN_MATCH;
+        while (ip + match < end && ref[match] == ip[match]) match++;
+        if (!lz_emit(op, op_end, anchor, ip - anchor, ip - ref, match)) return 0;
+        ip += match;
+        anchor = ip;
+    }
+    if (!lz_emit(op, op_end, anchor, end - anchor, 0, 0)) return 0;
+    return op - dst;
+}
+
+/* Decodes into exactly 'size' bytes, checking every length and offset. */
+static bool lz_decompress(const char* src, size_t n, char* dst, size_t size) {
+    const auto* ip = (const unsigned char*) src;
+    const auto* end = ip + n;
+    char* op = dst;
+    char* op_end = dst + size;
+    while (ip < end) {
+        const unsigned token = *ip++;
+        size_t literalbytes = token >> 4;
+        for (unsigned b = 255; literalbytes >= 15 && b == 255; literalbytes += b) {
+            if (ip == end) return false;
+            b = *ip++;
+        }
+        if ((size_t) (end - ip) < literalbytes || (size_t) (op_end - op) < literalbytes) return false;
+        std::memcpy(op, ip, literalbytes);
+        op += literalbytes;
+        ip += literalbytes;
+        if (ip == end) break;
+
+        if (end - ip < 2) return false;
+        const size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        size_t match = token & 15;
+        for (unsigned b = 255; match >= 15 && b == 255; match += b) {
+            if (ip == end) return false;
+            b = *ip++;
+        }
+        match += LZ_MIN_MATCH;
+        if (offset == 0 || offset > (size_t) (op - dst) || (size_t) (op_end - op) < match) return false;
+        const char* ref = op - offset;
+        if (offset >= match) {
+            std::memcpy(op, ref, match);
+        } else {
+            for (size_t i = 0; i < match; i++) op[i] = ref[i];
+        }
+        op += match;
+    }
+    return op == op_end;
+}
+
+#define CODEC_RAW 0
+#define CODEC_LZ 1
+#define CODEC_HEADER_BYTES 1
+#define CODEC_SIZE_BYTES 4
+#define CODEC_DEFAULT_MIN_BYTES 64
+#define CODEC_STATS 7
+
+struct CodecScratch {
+    std::vector<std::unique_ptr<std::vector<char>>> levels;
+    size_t depth = 0;
+};
+
+// decoded values are handed to callbacks that may read again, so every
+// nesting level gets its own buffer
+static thread_local CodecScratch codec_scratch;
+static thread_local std::vector<char> codec_encode_buffer;
+
+/*
+ * Optional value compression, enabled with "jni_compression": "lz". Every
+ * stored value then starts with a one-byte header: CODEC_RAW followed by
+ * the value, or CODEC_LZ followed by the uncompressed size (uint32,
+ * little-endian) and the LZ block. Values shorter than
+ * "jni_compression_min_bytes", or that do not shrink, are stored raw, so
+ * both kinds coexist. A pool written with compression must always be
+ * opened with it, as the header is not there otherwise.
+ */
+class Codec {
+public:
+    explicit Codec(size_t min_bytes) : min_bytes(min_bytes) {
+    }
+
+    /* Returns the stored form of the value, valid until the next encode on this thread. */
+    const std::vector<char>& encode(const char* v, size_t vb) {
+        auto& out = codec_encode_buffer;
+        const size_t prefix = CODEC_HEADER_BYTES + CODEC_SIZE_BYTES;
+        if (vb >= min_bytes && vb > prefix && vb <= UINT32_MAX) {
+            const auto start = stats_clock();
+            out.resize(vb);
+            const auto compressed = lz_compress(v, vb, out.data() + prefix, vb - prefix);
+            compress_ns.fetch_add(stats_clock() - start, std::memory_order_relaxed);
+            if (compressed > 0) {
+                out[0] = CODEC_LZ;
+                store_le32(out.data() + CODEC_HEADER_BYTES, (uint32_t) vb);
+                out.resize(prefix + compressed);
+                compressed_values.fetch_add(1, std::memory_order_relaxed);
+                account(vb, out.size());
+                return out;
+            }
+        }
+        out.resize(CODEC_HEADER_BYTES + vb);
+        out[0] = CODEC_RAW;
+        std::memcpy(out.data() + CODEC_HEADER_BYTES, v, vb);
+        raw_values.fetch_add(1, std::memory_order_relaxed);
+        account(vb, out.size());
+        return out;
+    }
+
+    /*
+     * Calls 'next' with the decoded value. Returns false, without calling
+     * it, if the value is corrupt.
+     */
+    template <typename F>
+    bool decode(const char* v, size_t vb, F next) {
+        if (vb < CODEC_HEADER_BYTES) return false;
+        if (v[0] == CODEC_RAW) {
+            next(v + CODEC_HEADER_BYTES, vb - CODEC_HEADER_BYTES);
+            return true;
+        }
+        if (v[0] != CODEC_LZ || vb < CODEC_HEADER_BYTES + CODEC_SIZE_BYTES) return false;
+
+        const size_t prefix = CODEC_HEADER_BYTES + CODEC_SIZE_BYTES;
+        const size_t size = load_le32(v + CODEC_HEADER_BYTES);
+        // a match byte expands to at most 255 bytes, so larger sizes are corrupt
+        if (size / 255 > vb) return false;
+
+        if (codec_scratch.levels.size() == codec_scratch.depth)
+            codec_scratch.levels.emplace_back(new std::vector<char>());
+        auto& out = *codec_scratch.levels[codec_scratch.depth];
+        if (out.size() < size) out.resize(size);
+        const auto start = stats_clock();
+        const bool ok = lz_decompress(v + prefix, vb - prefix, out.data(), size);
+        decompress_ns.fetch_add(stats_clock() - start, std::memory_order_relaxed);
+        decompressed_values.fetch_add(1, std::memory_order_relaxed);
+        if (!ok) return false;
+        codec_scratch.depth++;
+        next(out.data(), size);
+        codec_scratch.depth--;
+        return true;
+    }
+
+    /*
+     * {compressed values, raw values, bytes in, bytes stored, compression
+     * ns, decompressed values, decompression ns}
+     */
+    void stats(jlong* result) const {
+        result[0] = compressed_values.load(std::memory_order_relaxed);
+        result[1] = raw_values.load(std::memory_order_relaxed);
+        result[2] = bytes_in.load(std::memory_order_relaxed);
+        result[3] = bytes_stored.load(std::memory_order_relaxed);
+        result[4] = compress_ns.load(std::memory_order_relaxed);
+        result[5] = decompressed_values.load(std::memory_order_relaxed);
+        result[6] = decompress_ns.load(std::memory_order_relaxed);
+    }
+
+private:
+    void account(size_t in, size_t stored) {
+        bytes_in.fetch_add(in, std::memory_order_relaxed);
+        bytes_stored.fetch_add(stored, std::memory_order_relaxed);
+    }
+
+    size_t min_bytes;
+    std::atomic<uint64_t> compressed_values{0};
+    std::atomic<uint64_t> raw_values{0};
+    std::atomic<uint64_t> bytes_in{0};
+    std::atomic<uint64_t> bytes_stored{0};
+    std::atomic<uint64_t> compress_ns{0};
+    std::atomic<uint64_t> decompressed_values{0};
+    std::atomic<uint64_t> decompress_ns{0};
+};
+
+struct ContextDecode {
+    Codec* codec;
+    pmemkv_get_v_callback* callback;
+    void* arg;
+    bool corrupt;
+};
+
+const auto CALLBACK_DECODE = [](const char* v, size_t vb, void *arg) {
+    const auto c = ((ContextDecode*) arg);
+    c->corrupt = !c->codec->decode(v, vb, [c](const char* value, size_t valuebytes) {
+        c->callback(value, valuebytes, c->arg);
+    });
+};
+
+struct ContextDecodeKV {
+    Codec* codec;
+    pmemkv_get_kv_callback* callback;
+    void* arg;
+    bool corrupt;
+};
+
+const auto CALLBACK_DECODE_KV = [](const char* k, size_t kb, const char* v, size_t vb, void *arg) -> int {
+    const auto c = ((ContextDecodeKV*) arg);
+    int result = 0;
+    c->corrupt = !c->codec->decode(v, vb, [&](const char* value, size_t valuebytes) {
+        result = c->callback(k, kb, value, valuebytes, c->arg);
+    });
+    return c->corrupt ? 1 : result;
+};
+
+#define SHARD_SEED 0x5348415244ULL
+#define STRIPE_SEED 0x5354524950ULL
+#define LOCK_STRIPES 1024
+
+struct Database;
+static int kv_count_all(Database* db, size_t* count);
+static int kv_keys_all(Database* db, pmemkv_get_kv_callback* callback, void* arg);
+
+/*
+ * The handle returned by database_start. Point reads and writes go through
+ * it so that the optional cache and Bloom filter stay coherent; scans and
+ * counts go through the kv_* functions, which merge the shards.
+ */
+struct Database {
+    std::vector<pmemkv_db*> shards;
+    bool sorted;
+    bool borrow_stable = false;
+    std::unique_ptr<ReadCache> cache;
+    std::unique_ptr<Codec> codec;
+    // only set with "jni_atomic_ops": every write then holds its key's
+    // stripe, so read-modify-write operations holding it too are atomic
+    // with respect to all writes made here
+    std::unique_ptr<std::mutex[]> stripes;
+
+    // Filters are swapped by rebuild_bloom while readers may still hold the
+    // old one, so replaced filters are only freed when the database stops.
+    std::atomic<BloomFilter*> bloom{nullptr};
+    std::atomic<BloomFilter*> bloom_pending{nullptr};
+    std::vector<std::unique_ptr<BloomFilter>> bloom_retired;
+    std::mutex bloom_lock;
+    size_t bloom_bits_per_key = BLOOM_DEFAULT_BITS_PER_KEY;
+    std::string bloom_path;
+    std::atomic<uint64_t> bloom_skipped{0};
+    std::atomic<uint64_t> bloom_passed{0};
+    std::atomic<uint64_t> bloom_false{0};
+    std::atomic<uint64_t> snapshot_progress{0};
+
+    Database(const std::vector<pmemkv_db*>& shards, bool sorted) : shards(shards), sorted(sorted) {
+    }
+
+    ~Database() {
+        delete bloom.load();
+    }
+
+    pmemkv_db* shard(const char* k, size_t kb) const {
+        if (shards.size() == 1) return shards[0];
+        return shards[hash_key(k, kb, SHARD_SEED) % shards.size()];
+    }
+
+    int get(const char* k, size_t kb, pmemkv_get_v_callback* callback, void* arg) {
+        stats_bytes(kb);
+        if (!may_contain(k, kb)) return PMEMKV_STATUS_NOT_FOUND;
+        int status;
+        if (cache == nullptr) {
+            status = read(k, kb, callback, arg);
+        } else if (cache->get(k, kb, callback, arg)) {
+            status = PMEMKV_STATUS_OK;
+        } else {
+            ContextCacheFill cxt = {cache.get(), k, kb, cache->version(k, kb), callback, arg};
+            status = read(k, kb, CALLBACK_CACHE_FILL, &cxt);
+        }
+        return filtered(status);
+    }
+
+    /* Reads and decodes a value from the engine, bypassing cache and filter. */
+    int read(const char* k, size_t kb, pmemkv_get_v_callback* callback, void* arg) {
+        if (codec == nullptr) return timed(pmemkv_get, shard(k, kb), k, kb, callback, arg);
+        ContextDecode cxt = {codec.get(), callback, arg, false};
+        const auto status = timed(pmemkv_get, shard(k, kb), k, kb, CALLBACK_DECODE, &cxt);
+        return cxt.corrupt ? PMEMKV_STATUS_UNKNOWN_ERROR : status;
+    }
+
+    int exists(const char* k, size_t kb) {
+        stats_bytes(kb);
+        if (!may_contain(k, kb)) return PMEMKV_STATUS_NOT_FOUND;
+        if (cache != nullptr && cache->get(k, kb, [](const char*, size_t, void*) {}, nullptr))
+            return PMEMKV_STATUS_OK;
+        return filtered(timed(pmemkv_exists, shard(k, kb), k, kb));
+    }
+
+    /* Holds the key's stripe, or nothing when atomic operations are off. */
+    std::unique_lock<std::mutex> lock_stripe(const char* k, size_t kb) {
+        if (stripes == nullptr) return std::unique_lock<std::mutex>();
+        return std::unique_lock<std::mutex>(stripes[hash_key(k, kb, STRIPE_SEED) % LOCK_STRIPES]);
+    }
+
+    int put(const char* k, size_t kb, const char* v, size_t vb) {
+        const auto guard = lock_stripe(k, kb);
+        return put_locked(k, kb, v, vb);
+    }
+
+    /* Put for callers already holding the key's stripe. */
+    int put_locked(const char* k, size_t kb, const char* v, size_t vb) {
+        stats_bytes(kb + vb);
+        // the key goes into the filter first, so a reader can never see it
+        // in the engine but not in the filter
+        const auto filter = bloom.load();
+        const auto pending = bloom_pending.load();
+        if (filter != nullptr) filter->insert(k, kb);
+        if (pending != nullptr) pending->insert(k, kb);
+        int status;
+        if (codec == nullptr) {
+            status = timed(pmemkv_put, shard(k, kb), k, kb, v, vb);
+        } else {
+            const auto& stored = codec->encode(v, vb);
+            status = timed(pmemkv_put, shard(k, kb), k, kb, stored.data(), stored.size());
+        }
+        if (cache != nullptr) cache->invalidate(k, kb);
+        // a rebuild that started after the inserts above may have scanned
+        // past this key already
+        const auto now = bloom.load();
+        const auto now_pending = bloom_pending.load();
+        if (now != filter && now != nullptr) now->insert(k, kb);
+        if (now_pending != pending && now_pending != nullptr) now_pending->insert(k, kb);
+        return status;
+    }
+
+    int remove(const char* k, size_t kb) {
+        stats_bytes(kb);
+        const auto guard = lock_stripe(k, kb);
+        const auto status = timed(pmemkv_remove, shard(k, kb), k, kb);
+        if (cache != nullptr) cache->invalidate(k, kb);
+        return status;
+    }
+
+    /* Rebuilds the filter from a full scan, enabling it if it was off. */
+    int rebuild_bloom() {
+        std::lock_guard<std::mutex> guard(bloom_lock);
+        size_t count = 0;
+        auto status = kv_count_all(this, &count);
+        if (status != PMEMKV_STATUS_OK) return status;
+        std::unique_ptr<BloomFilter> filter(new BloomFilter(count, bloom_bits_per_key));
+        bloom_pending.store(filter.get());
+        status = kv_keys_all(this, CALLBACK_BLOOM_INSERT, filter.get());
+        if (status == PMEMKV_STATUS_OK) {
+            bloom_retired.emplace_back(bloom.exchange(filter.release()));
+            bloom_skipped = bloom_passed = bloom_false = 0;
+        }
+        bloom_pending.store(nullptr);
+        return status;
+    }
+
+    /*
+     * Loads the sidecar if it matches the engines, otherwise rebuilds. The
+     * sidecar is removed once loaded and only written back by a clean
+     * stop, so one left behind by a crash is never trusted.
+     */
+    int open_bloom() {
+        size_t count = 0;
+        if (!bloom_path.empty() && kv_count_all(this, &count) == PMEMKV_STATUS_OK) {
+            const auto filter = BloomFilter::load(bloom_path, count);
+            std::remove(bloom_path.c_str());
+            if (filter != nullptr) {
+                bloom.store(filter);
+                return PMEMKV_STATUS_OK;
+            }
+        }
+        return rebuild_bloom();
+    }
+
+    void close_bloom() {
+        size_t count = 0;
+        const auto filter = bloom.load();
+        if (filter != nullptr && !bloom_path.empty() && kv_count_all(this, &count) == PMEMKV_STATUS_OK)
+            filter->save(bloom_path, count);
+    }
+
+private:
+    bool may_contain(const char* k, size_t kb) {
+        const auto filter = bloom.load(std::memory_order_acquire);
+        if (filter == nullptr || filter->may_contain(k, kb)) return true;
+        bloom_skipped++;
+        return false;
+    }
+
+    int filtered(int status) {
+        if (bloom.load(std::memory_order_relaxed) == nullptr) return status;
+        bloom_passed++;
+        if (status == PMEMKV_STATUS_NOT_FOUND) bloom_false++;
+        return status;
+    }
+};
+
+static bool config_get_uint64(pmemkv_config* cfg, const char* key, uint64_t* value) {
+    int64_t signed_value;
+    if (pmemkv_config_get_uint64(cfg, key, value) == PMEMKV_STATUS_OK) return true;
+    if (pmemkv_config_get_int64(cfg, key, &signed_value) != PMEMKV_STATUS_OK || signed_value < 0) return false;
+    *value = signed_value;
+    return true;
+}
+
+#define SORTED_ENGINES {"vsmap", "stree", "csmap", "radix"}
+
+/*
+ * Engines which keep the value pointer passed to the get callback stable
+ * against concurrent writers (they hold a read accessor for the duration of
+ * the callback). With other engines a borrowed view is only safe when no
+ * other thread writes to the same key while it is in use.
+ */
+#define BORROW_STABLE_ENGINES {"cmap", "vcmap", "csmap"}
+
+static std::vector<std::string> split_list(const char* list) {
+    std::vector<std::string> result;
+    if (list == nullptr) return result;
+    std::string item;
+    for (const char* c = list;; c++) {
+        if (*c == ',' || *c == '\0') {
+            if (!item.empty()) result.push_back(item);
+            item.clear();
+            if (*c == '\0') break;
+        } else if (*c != ' ') {
+            item += *c;
+        }
+    }
+    return result;
+}
+
+#ifdef __linux__
+/* Reads a node's cpulist from sysfs, e.g. "0-15,32-47". */
+static bool node_cpus(int node, cpu_set_t* set) {
+    const auto path = "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist";
+    FILE* file = fopen(path.c_str(), "r");
+    if (file == nullptr) return false;
+    char list[4096] = {};
+    const bool read = fgets(list, sizeof(list), file) != nullptr;
+    fclose(file);
+    if (!read) return false;
+    CPU_ZERO(set);
+    for (const auto& range : split_list(list)) {
+        unsigned first, last;
+        const auto fields = sscanf(range.c_str(), "%u-%u", &first, &last);
+        if (fields < 1) continue;
+        if (fields == 1) last = first;
+        for (auto cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) CPU_SET(cpu, set);
+    }
+    return CPU_COUNT(set) > 0;
+}
+#endif
+
+/*
+ * Opens an engine from a thread bound to the CPUs of 'node', so that what
+ * the engine allocates while opening is placed on that node by the kernel's
+ * first-touch policy. A negative node opens from the calling thread.
+ * pmemkv_errormsg is per thread, so the opening thread's message is copied
+ * to 'error'.
+ *
+ * This is a best-effort hint, only meaningful for volatile engines that
+ * allocate their DRAM structures while opening. Nothing is bound: memory
+ * the engine allocates later is placed by whichever thread writes, and a
+ * persistent pool lives wherever its file or device does.
+ */
+static int open_on_node(int node, const char* engine, pmemkv_config* cfg, pmemkv_db** db, std::string& error) {
+    int status = PMEMKV_STATUS_UNKNOWN_ERROR;
+    const auto open = [&] {
+#ifdef __linux__
+        cpu_set_t set;
+        if (node >= 0 && node_cpus(node, &set)) pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+        status = pmemkv_open(engine, cfg, db);
+        if (status != PMEMKV_STATUS_OK) error = pmemkv_errormsg();
+    };
+    if (node < 0) {
+        open();
+    } else {
+        std::thread opener(open);
+        opener.join();
+    }
+    return status;
+}
+
+/*
+ * The keys a config built for start_database holds: all of them, only
+ * those meant for the engine, or those for one shard of several, which
+ * gets its own "path" (pmemkv does not let a key be put twice).
+ */
+enum ConfigScope { CONFIG_ALL, CONFIG_ENGINE, CONFIG_SHARD };
+
+static bool config_key_in_scope(const char* key, ConfigScope scope) {
+    if (scope == CONFIG_ALL) return true;
+    if (std::strncmp(key, "jni_", 4) == 0) return false;
+    return scope != CONFIG_SHARD || std::strcmp(key, "path") != 0;
+}
+
+/*
+ * Opens 'count' shards, each with a fresh config from 'make_config';
+ * pmemkv_open consumes each of them. With more than one shard, shard i
+ * uses the i-th entry of 'paths' as its "path", or "<base_path>.<i>" when
+ * no list is given, and is opened on node nodes[i % nodes.size()]. On
+ * failure the shards opened so far are closed.
+ */
+template <typename MakeConfig>
+static bool open_shards(const char* engine, const MakeConfig& make_config, size_t count,
+                        const std::string& base_path, const std::vector<std::string>& paths,
+                        const std::vector<int>& nodes, std::vector<pmemkv_db*>& shards, std::string& error) {
+    for (size_t i = 0; i < count; i++) {
+        const auto cfg = make_config(count > 1 ? CONFIG_SHARD : CONFIG_ENGINE);
+        if (cfg == nullptr) {
+            error = pmemkv_errormsg();
+            break;
+        }
+        if (count > 1) {
+            const auto shard_path = i < paths.size() ? paths[i] : base_path + "." + std::to_string(i);
+            if (pmemkv_config_put_string(cfg, "path", shard_path.c_str()) != PMEMKV_STATUS_OK) {
+                error = pmemkv_errormsg();
+                pmemkv_config_delete(cfg);
+                break;
+            }
+        }
+        pmemkv_db* shard;
+        const int node = nodes.empty() ? -1 : nodes[i % nodes.size()];
+        if (open_on_node(node, engine, cfg, &shard, error) != PMEMKV_STATUS_OK) break;
+        shards.push_back(shard);
+    }
+    if (shards.size() == count) return true;
+    for (auto shard : shards) pmemkv_close(shard);
+    shards.clear();
+    return false;
+}
+
+/*
+ * Reads the jni_* settings from the full config returned by
+ * 'make_config(CONFIG_ALL)', then opens the database with configs built
+ * for narrower scopes, so that the jni_* keys never reach the engine.
+ * Throws and returns 0 on failure.
+ */
+template <typename MakeConfig>
+static jlong start_database(JNIEnv* env, const char* engine, const MakeConfig& make_config) {
+    auto cfg = make_config(CONFIG_ALL);
+    if (cfg == nullptr) {
+        throw_exception(env, pmemkv_errormsg());
+        return 0;
+    }
+
+    uint64_t cache_bytes = 0;
+    uint64_t cache_shards = CACHE_DEFAULT_SHARDS;
+    config_get_uint64(cfg, "jni_cache_bytes", &cache_bytes);
+    config_get_uint64(cfg, "jni_cache_shards", &cache_shards);
+    uint64_t bloom_bits_per_key = 0;
+    const char* bloom_path = nullptr;
+    config_get_uint64(cfg, "jni_bloom_bits_per_key", &bloom_bits_per_key);
+    pmemkv_config_get_string(cfg, "jni_bloom_path", &bloom_path);
+    const std::string sidecar = bloom_path != nullptr ? bloom_path : "";
+    const char* shard_paths = nullptr;
+    const char* numa_nodes = nullptr;
+    pmemkv_config_get_string(cfg, "jni_shard_paths", &shard_paths);
+    pmemkv_config_get_string(cfg, "jni_numa_nodes", &numa_nodes);
+    const auto paths = split_list(shard_paths);
+    std::vector<int> nodes;
+    for (const auto& node : split_list(numa_nodes)) nodes.push_back(std::atoi(node.c_str()));
+    uint64_t shard_count = std::max(paths.size(), (size_t) 1);
+    config_get_uint64(cfg, "jni_shards", &shard_count);
+    const char* compression = nullptr;
+    uint64_t compression_min_bytes = CODEC_DEFAULT_MIN_BYTES;
+    pmemkv_config_get_string(cfg, "jni_compression", &compression);
+    config_get_uint64(cfg, "jni_compression_min_bytes", &compression_min_bytes);
+    uint64_t atomic_ops = 0;
+    config_get_uint64(cfg, "jni_atomic_ops", &atomic_ops);
+    const bool compress = compression != nullptr && std::strcmp(compression, "none") != 0;
+    const bool lz = compress && std::strcmp(compression, "lz") == 0;
+    const char* path = nullptr;
+    pmemkv_config_get_string(cfg, "path", &path);
+    const std::string base_path = path != nullptr ? path : "";
+    pmemkv_config_delete(cfg);
+    if (shard_count == 0) {
+        throw_exception(env, "Invalid jni_shards");
+        return 0;
+    }
+    if (compress && !lz) {
+        throw_exception(env, "Invalid jni_compression");
+        return 0;
+    }
+
+    std::vector<pmemkv_db*> shards;
+    std::string error;
+    if (!open_shards(engine, make_config, shard_count, base_path, paths, nodes, shards, error)) {
+        throw_exception(env, error.c_str());
+        return 0;
+    }
+    bool sorted = false;
+    for (const auto name : SORTED_ENGINES) sorted = sorted || std::strcmp(engine, name) == 0;
+
+    auto db = new Database(shards, sorted);
+    for (const auto name : BORROW_STABLE_ENGINES)
+        db->borrow_stable = db->borrow_stable || std::strcmp(engine, name) == 0;
+    if (cache_bytes > 0 && cache_shards > 0)
+        db->cache.reset(new ReadCache(cache_bytes, cache_shards));
+    if (compress) db->codec.reset(new Codec(compression_min_bytes));
+    if (atomic_ops != 0) db->stripes.reset(new std::mutex[LOCK_STRIPES]);
+    if (bloom_bits_per_key > 0) {
+        db->bloom_bits_per_key = bloom_bits_per_key;
+        db->bloom_path = sidecar;
+        if (db->open_bloom() != PMEMKV_STATUS_OK) {
+            for (auto shard : shards) pmemkv_close(shard);
+            delete db;
+            throw_exception(env, pmemkv_errormsg());
+            return 0;
+        }
+    }
+    return (jlong) db;
+}
+
+/* Scans past one JSON value starting at 'p', returning nullptr if malformed. */
+static const char* skip_json_value(const char* p) {
+    int depth = 0;
+    for (; *p != '\0'; p++) {
+        if (*p == '"') {
+            for (p++; *p != '"'; p++) {
+                if (*p == '\0') return nullptr;
+                if (*p == '\\' && *++p == '\0') return nullptr;
+            }
+        } else if (*p == '{' || *p == '[') {
+            depth++;
+        } else if (*p == '}' || *p == ']') {
+            if (depth == 0) return p;
+            depth--;
+        } else if (*p == ',' && depth == 0) {
+            return p;
+        }
+    }
+    return depth == 0 ? p : nullptr;
+}
+
+static const char* skip_json_space(const char* p) {
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++;
+    return p;
+}
+
+/*
+ * Returns the JSON object 'json' with only the top-level members in
+ * 'scope'. Text that is not a plain object is returned unchanged, for
+ * pmemkv_config_from_json to judge.
+ */
+static std::string strip_config_keys(const char* json, ConfigScope scope) {
+    std::string result = "{";
+    const char* p = skip_json_space(json);
+    if (*p++ != '{') return json;
+    for (p = skip_json_space(p); *p != '}'; p = skip_json_space(p + 1)) {
+        if (*p != '"') return json;
+        const char* member = p;
+        const char* name_end = std::strchr(p + 1, '"');
+        const std::string name(p + 1, name_end != nullptr ? name_end - p - 1 : 0);
+        p = skip_json_value(p);
+        if (p == nullptr || *p == '\0') return json;
+        if (config_key_in_scope(name.c_str(), scope)) {
+            if (result.size() > 1) result += ',';
+            result.append(member, p - member);
+        }
+        if (*p == '}') break;
+    }
+    return result + "}";
+}
+
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1start
+        (JNIEnv* env, jobject obj, jstring engine, jstring config) {
+    const char* cengine = env->GetStringUTFChars(engine, NULL);
+    if (cengine == nullptr) return 0;
+    const char* cconfig = env->GetStringUTFChars(config, NULL);
+    if (cconfig == nullptr) {
+        env->ReleaseStringUTFChars(engine, cengine);
+        return 0;
+    }
+
+    const auto result = start_database(env, cengine, [cconfig](ConfigScope scope) -> pmemkv_config* {
+        auto cfg = pmemkv_config_new();
+        const auto json = strip_config_keys(cconfig, scope);
+        if (cfg != nullptr && pmemkv_config_from_json(cfg, json.c_str()) != PMEMKV_STATUS_OK) {
+            pmemkv_config_delete(cfg);
+            return nullptr;
+        }
+        return cfg;
+    });
+
+    env->ReleaseStringUTFChars(engine, cengine);
+    env->ReleaseStringUTFChars(config, cconfig);
+    return result;
+}
+
+/*
+ * Typed config handle. Entries are kept natively and copied into a new
+ * pmemkv_config on every open, since pmemkv_open consumes its config, so
+ * one handle can open any number of databases without going through JSON.
+ * Putting a key that is already set replaces its value.
+ */
+struct Config {
+    enum Type { STRING, UINT64, INT64, OBJECT };
+    struct Entry {
+        std::string key;
+        Type type;
+        std::string string;
+        uint64_t number;
+        void* object;
+    };
+    std::vector<Entry> entries;
+
+    Entry& put(const char* key, Type type) {
+        for (auto& entry : entries) {
+            if (entry.key == key) {
+                entry.type = type;
+                return entry;
+            }
+        }
+        entries.push_back(Entry{key, type, std::string(), 0, nullptr});
+        return entries.back();
+    }
+
+    /* Builds a pmemkv_config with the entries in 'scope'. */
+    pmemkv_config* build(ConfigScope scope) const {
+        auto cfg = pmemkv_config_new();
+        if (cfg == nullptr) return nullptr;
+        for (const auto& entry : entries) {
+            if (!config_key_in_scope(entry.key.c_str(), scope)) continue;
+            int status = PMEMKV_STATUS_OK;
+            switch (entry.type) {
+                case STRING:
+                    status = pmemkv_config_put_string(cfg, entry.key.c_str(), entry.string.c_str());
+                    break;
+                case UINT64:
+                    status = pmemkv_config_put_uint64(cfg, entry.key.c_str(), entry.number);
+                    break;
+                case INT64:
+                    status = pmemkv_config_put_int64(cfg, entry.key.c_str(), (int64_t) entry.number);
+                    break;
+                case OBJECT:
+                    status = pmemkv_config_put_object(cfg, entry.key.c_str(), entry.object, nullptr);
+                    break;
+            }
+            if (status != PMEMKV_STATUS_OK) {
+                pmemkv_config_delete(cfg);
+                return nullptr;
+            }
+        }
+        return cfg;
+    }
+};
+
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1config_1new
+        (JNIEnv* env, jobject obj) {
+    return (jlong) new Config();
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1config_1delete
+        (JNIEnv* env, jobject obj, jlong config) {
+    delete (Config*) config;
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1config_1put_1string
+        (JNIEnv* env, jobject obj, jlong config, jstring key, jstring value) {
+    const char* ckey = env->GetStringUTFChars(key, NULL);
+    if (ckey == nullptr) return;
+    const char* cvalue = env->GetStringUTFChars(value, NULL);
+    if (cvalue != nullptr) {
+        ((Config*) config)->put(ckey, Config::STRING).string = cvalue;
+        env->ReleaseStringUTFChars(value, cvalue);
+    }
+    env->ReleaseStringUTFChars(key, ckey);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1config_1put_1uint64
+        (JNIEnv* env, jobject obj, jlong config, jstring key, jlong value) {
+    const char* ckey = env->GetStringUTFChars(key, NULL);
+    if (ckey == nullptr) return;
+    ((Config*) config)->put(ckey, Config::UINT64).number = (uint64_t) value;
+    env->ReleaseStringUTFChars(key, ckey);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1config_1put_1int64
+        (JNIEnv* env, jobject obj, jlong config, jstring key, jlong value) {
+    const char* ckey = env->GetStringUTFChars(key, NULL);
+    if (ckey == nullptr) return;
+    ((Config*) config)->put(ckey, Config::INT64).number = (uint64_t) value;
+    env->ReleaseStringUTFChars(key, ckey);
+}
+
+/*
+ * Stores a native object pointer, e.g. a pmem::obj::pool_base* for the
+ * "oid" key. The caller keeps ownership: no deleter is registered, so the
+ * object must outlive every open that uses this handle.
+ */
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1config_1put_1object
+        (JNIEnv* env, jobject obj, jlong config, jstring key, jlong value) {
+    const char* ckey = env->GetStringUTFChars(key, NULL);
+    if (ckey == nullptr) return;
+    ((Config*) config)->put(ckey, Config::OBJECT).object = (void*) value;
+    env->ReleaseStringUTFChars(key, ckey);
+}
+
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1start_1config
+        (JNIEnv* env, jobject obj, jstring engine, jlong config) {
+    const char* cengine = env->GetStringUTFChars(engine, NULL);
+    if (cengine == nullptr) return 0;
+    const auto handle = (const Config*) config;
+    const auto result = start_database(env, cengine, [handle](ConfigScope scope) { return handle->build(scope); });
+    env->ReleaseStringUTFChars(engine, cengine);
+    return result;
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1stop
+        (JNIEnv* env, jobject obj, jlong pointer) {
+    auto db = (Database*) pointer;
+    db->close_bloom();
+    for (auto shard : db->shards) pmemkv_close(shard);
+    delete db;
+    scratch_release_all(env);
+}
+
+static inline int32_t read_int32(const char* p) {
+    int32_t result;
+    std::memcpy(&result, p, sizeof(result));
+    return result;
+}
+
+static inline void write_int32(char* p, int32_t value) {
+    std::memcpy(p, &value, sizeof(value));
+}
+
+static int compare_keys(const char* k1, size_t kb1, const char* k2, size_t kb2) {
+    const auto result = std::memcmp(k1, k2, std::min(kb1, kb2));
+    if (result != 0) return result;
+    return kb1 < kb2 ? -1 : (kb1 > kb2 ? 1 : 0);
+}
+
+/*
+ * Scans and counts over all shards. Counts are summed. On sorted engines a
+ * range scan over several shards is a k-way merge: every shard is read a
+ * page at a time, resuming above the last key of its previous page, and
+ * the smallest current key is handed to the callback. Keys never repeat
+ * across shards, as every key lives in exactly one. Unsorted engines are
+ * scanned one shard after another.
+ */
+#define SHARD_PAGE_ENTRIES 64
+
+struct ShardStream {
+    pmemkv_db* engine;
+    std::string lower;
+    bool has_lower;
+    const char* upper;
+    size_t upperbytes;
+    bool has_upper;
+    std::vector<char> page;
+    std::vector<size_t> records;
+    size_t next;
+    bool done;
+
+    const char* record() const {
+        return page.data() + records[next];
+    }
+
+    size_t keybytes() const {
+        return read_int32(record());
+    }
+
+    size_t valuebytes() const {
+        return read_int32(record() + sizeof(int32_t));
+    }
+
+    const char* key() const {
+        return record() + 2 * sizeof(int32_t);
+    }
+
+    const char* value() const {
+        return key() + keybytes();
+    }
+
+    bool empty() const {
+        return next == records.size();
+    }
+
+    int fill();
+};
+
+const auto CALLBACK_SHARD_PAGE = [](const char* k, size_t kb, const char* v, size_t vb, void *arg) -> int {
+    const auto s = ((ShardStream*) arg);
+    char header[2 * sizeof(int32_t)];
+    write_int32(header, kb);
+    write_int32(header + sizeof(int32_t), vb);
+    s->records.push_back(s->page.size());
+    s->page.insert(s->page.end(), header, header + sizeof(header));
+    s->page.insert(s->page.end(), k, k + kb);
+    s->page.insert(s->page.end(), v, v + vb);
+    return s->records.size() == SHARD_PAGE_ENTRIES;
+};
+
+int ShardStream::fill() {
+    page.clear();
+    records.clear();
+    next = 0;
+    int status;
+    if (has_lower && has_upper)
+        status = pmemkv_get_between(engine, lower.data(), lower.size(), upper, upperbytes, CALLBACK_SHARD_PAGE, this);
+    else if (has_lower)
+        status = pmemkv_get_above(engine, lower.data(), lower.size(), CALLBACK_SHARD_PAGE, this);
+    else if (has_upper)
+        status = pmemkv_get_below(engine, upper, upperbytes, CALLBACK_SHARD_PAGE, this);
+    else
+        status = pmemkv_get_all(engine, CALLBACK_SHARD_PAGE, this);
+    done = records.size() < SHARD_PAGE_ENTRIES;
+    if (!records.empty()) {
+        const char* last = page.data() + records.back();
+        lower.assign(last + 2 * sizeof(int32_t), read_int32(last));
+        has_lower = true;
+    }
+    return status == PMEMKV_STATUS_STOPPED_BY_CB ? PMEMKV_STATUS_OK : status;
+}
+
+static int merge_scan(Database* db, const char* k1, size_t kb1, bool has_lower, const char* k2, size_t kb2,
+                      bool has_upper, pmemkv_get_kv_callback* callback, void* arg) {
+    std::vector<ShardStream> streams(db->shards.size());
+    std::vector<size_t> heap;
+    const auto greater = [&streams](size_t a, size_t b) {
+        const auto& s1 = streams[a];
+        const auto& s2 = streams[b];
+        return compare_keys(s1.key(), s1.keybytes(), s2.key(), s2.keybytes()) > 0;
+    };
+    for (size_t i = 0; i < streams.size(); i++) {
+        auto& s = streams[i];
+        s.engine = db->shards[i];
+        s.lower.assign(k1, has_lower ? kb1 : 0);
+        s.has_lower = has_lower;
+        s.upper = k2;
+        s.upperbytes = kb2;
+        s.has_upper = has_upper;
+        const auto status = s.fill();
+        if (status != PMEMKV_STATUS_OK) return status;
+        if (!s.empty()) heap.push_back(i);
+    }
+    std::make_heap(heap.begin(), heap.end(), greater);
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), greater);
+        auto& s = streams[heap.back()];
+        if (callback(s.key(), s.keybytes(), s.value(), s.valuebytes(), arg) != 0)
+            return PMEMKV_STATUS_STOPPED_BY_CB;
+        s.next++;
+        if (s.empty() && !s.done) {
+            const auto status = s.fill();
+            if (status != PMEMKV_STATUS_OK) return status;
+        }
+        if (s.empty())
+            heap.pop_back();
+        else
+            std::push_heap(heap.begin(), heap.end(), greater);
+    }
+    return PMEMKV_STATUS_OK;
+}
+
+template <typename F>
+static int each_shard(Database* db, F scan) {
+    for (auto shard : db->shards) {
+        const auto status = scan(shard);
+        if (status != PMEMKV_STATUS_OK) return status;
+    }
+    return PMEMKV_STATUS_OK;
+}
+
+/*
+ * The kv_keys_* scans hand values to the callback as stored, which is all
+ * that callbacks reading only keys need. The kv_get_* scans decode them
+ * first when compression is on.
+ */
+static int kv_keys_all(Database* db, pmemkv_get_kv_callback* callback, void* arg) {
+    if (db->shards.size() > 1 && db->sorted) return merge_scan(db, nullptr, 0, false, nullptr, 0, false, callback, arg);
+    return each_shard(db, [&](pmemkv_db* shard) { return pmemkv_get_all(shard, callback, arg); });
+}
+
+static int kv_keys_above(Database* db, const char* k, size_t kb, pmemkv_get_kv_callback* callback, void* arg) {
+    if (db->shards.size() > 1 && db->sorted) return merge_scan(db, k, kb, true, nullptr, 0, false, callback, arg);
+    return each_shard(db, [&](pmemkv_db* shard) { return pmemkv_get_above(shard, k, kb, callback, arg); });
+}
+
+static int kv_keys_below(Database* db, const char* k, size_t kb, pmemkv_get_kv_callback* callback, void* arg) {
+    if (db->shards.size() > 1 && db->sorted) return merge_scan(db, nullptr, 0, false, k, kb, true, callback, arg);
+    return each_shard(db, [&](pmemkv_db* shard) { return pmemkv_get_below(shard, k, kb, callback, arg); });
+}
+
+static int kv_keys_between(Database* db, const char* k1, size_t kb1, const char* k2, size_t kb2,
+                          pmemkv_get_kv_callback* callback, void* arg) {
+    if (db->shards.size() > 1 && db->sorted) return merge_scan(db, k1, kb1, true, k2, kb2, true, callback, arg);
+    return each_shard(db, [&](pmemkv_db* shard) { return pmemkv_get_between(shard, k1, kb1, k2, kb2, callback, arg); });
+}
+
+template <typename F>
+static int decoded(Database* db, pmemkv_get_kv_callback* callback, void* arg, F scan) {
+    if (db->codec == nullptr) return scan(callback, arg);
+    ContextDecodeKV cxt = {db->codec.get(), callback, arg, false};
+    const auto status = scan(CALLBACK_DECODE_KV, &cxt);
+    return cxt.corrupt ? PMEMKV_STATUS_UNKNOWN_ERROR : status;
+}
+
+static int kv_get_all(Database* db, pmemkv_get_kv_callback* callback, void* arg) {
+    return decoded(db, callback, arg, [&](pmemkv_get_kv_callback* cb, void* a) { return kv_keys_all(db, cb, a); });
+}
+
+static int kv_get_above(Database* db, const char* k, size_t kb, pmemkv_get_kv_callback* callback, void* arg) {
+    return decoded(db, callback, arg, [&](pmemkv_get_kv_callback* cb, void* a) {
+        return kv_keys_above(db, k, kb, cb, a);
+    });
+}
+
+static int kv_get_below(Database* db, const char* k, size_t kb, pmemkv_get_kv_callback* callback, void* arg) {
+    return decoded(db, callback, arg, [&](pmemkv_get_kv_callback* cb, void* a) {
+        return kv_keys_below(db, k, kb, cb, a);
+    });
+}
+
+static int kv_get_between(Database* db, const char* k1, size_t kb1, const char* k2, size_t kb2,
+                          pmemkv_get_kv_callback* callback, void* arg) {
+    return decoded(db, callback, arg, [&](pmemkv_get_kv_callback* cb, void* a) {
+        return kv_keys_between(db, k1, kb1, k2, kb2, cb, a);
+    });
+}
+
+template <typename F>
+static int sum_shards(Database* db, size_t* count, F counter) {
+    *count = 0;
+    return each_shard(db, [&](pmemkv_db* shard) {
+        size_t shard_count = 0;
+        const auto status = counter(shard, &shard_count);
+        *count += shard_count;
+        return status;
+    });
+}
+
+static int kv_count_all(Database* db, size_t* count) {
+    return sum_shards(db, count, [&](pmemkv_db* shard, size_t* c) { return pmemkv_count_all(shard, c); });
+}
+
+static int kv_count_above(Database* db, const char* k, size_t kb, size_t* count) {
+    return sum_shards(db, count, [&](pmemkv_db* shard, size_t* c) { return pmemkv_count_above(shard, k, kb, c); });
+}
+
+static int kv_count_below(Database* db, const char* k, size_t kb, size_t* count) {
+    return sum_shards(db, count, [&](pmemkv_db* shard, size_t* c) { return pmemkv_count_below(shard, k, kb, c); });
+}
+
+static int kv_count_between(Database* db, const char* k1, size_t kb1, const char* k2, size_t kb2, size_t* count) {
+    return sum_shards(db, count, [&](pmemkv_db* shard, size_t* c) {
+        return pmemkv_count_between(shard, k1, kb1, k2, kb2, c);
+    });
+}
+
+/* Point lookups that bypass the cache and Bloom filter, as scans do. */
+static int kv_get(Database* db, const char* k, size_t kb, pmemkv_get_v_callback* callback, void* arg) {
+    return db->read(k, kb, callback, arg);
+}
+
+static int kv_exists(Database* db, const char* k, size_t kb) {
+    return pmemkv_exists(db->shard(k, kb), k, kb);
+}
+
+/*
+ * Scan callbacks stop the iteration once a Java callback has thrown, or when
+ * 'remaining', counting down from the caller's limit, reaches zero. A limit
+ * of zero or less means no limit. Stopping makes pmemkv return
+ * PMEMKV_STATUS_STOPPED_BY_CB, which is not an error here.
+ */
+static inline int scan_next(JNIEnv* env, jlong& remaining) {
+    if (env->ExceptionCheck()) return 1;
+    return remaining > 0 && --remaining == 0;
+}
+
+static inline bool scan_failed(int status) {
+    return status != PMEMKV_STATUS_OK && status != PMEMKV_STATUS_STOPPED_BY_CB;
+}
+
+struct Context {
+    JNIEnv* env;
+    jobject callback;
+    jmethodID mid;
+    jlong remaining;
+};
+
+#define CONTEXT {env, callback, mid, limit}
+
+struct ContextGetKeysBuffer {
+    JNIEnv* env;
+    jobject callback;
+    jmethodID mid;
+    ScratchLevel* scratch;
+    jlong remaining;
+};
+
+#define CONTEXT_GET_KEYS_BUFFER {env, callback, mid, scope.level, limit}
+
+const auto CALLBACK_GET_KEYS_BUFFER = [](const char* k, size_t kb, const char* v, size_t vb, void *arg) -> int {
+    stats_bytes(kb);
+    const auto c = ((ContextGetKeysBuffer*) arg);
+    if (!scratch_reserve(c->env, c->scratch->key, kb)) return 1;
+    std::memcpy(c->scratch->key.data, k, kb);
+    c->env->CallVoidMethod(c->callback, c->mid, kb, c->scratch->key.buffer);
+    return scan_next(c->env, c->remaining);
+};
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1buffer
+        (JNIEnv* env, jobject obj, jlong pointer, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1keys_1buffer_1limit(env, obj, pointer, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1buffer_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_KEYS_BUFFER);
+    auto db = (Database*) pointer;
+    const auto mid = callback_method(env, callback, GET_KEYS_BUFFER_METHOD);
+    ScratchScope scope;
+    ContextGetKeysBuffer cxt = CONTEXT_GET_KEYS_BUFFER;
+    auto status = timed(kv_keys_all, db, CALLBACK_GET_KEYS_BUFFER, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1buffer
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1buffer_1limit(env, obj, pointer, keybytes, key, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1buffer_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_KEYS_BUFFER);
+    auto db = (Database*) pointer;
+    const char* ckey = (char*) env->GetDirectBufferAddress(key);
+    const auto mid = callback_method(env, callback, GET_KEYS_BUFFER_METHOD);
+    ScratchScope scope;
+    ContextGetKeysBuffer cxt = CONTEXT_GET_KEYS_BUFFER;
+    auto status = timed(kv_keys_above, db, ckey, keybytes, CALLBACK_GET_KEYS_BUFFER, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1buffer
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1buffer_1limit(env, obj, pointer, keybytes, key, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1buffer_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_KEYS_BUFFER);
+    auto db = (Database*) pointer;
+    const char* ckey = (char*) env->GetDirectBufferAddress(key);
+    const auto mid = callback_method(env, callback, GET_KEYS_BUFFER_METHOD);
+    ScratchScope scope;
+    ContextGetKeysBuffer cxt = CONTEXT_GET_KEYS_BUFFER;
+    auto status = timed(kv_keys_below, db, ckey, keybytes, CALLBACK_GET_KEYS_BUFFER, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1buffer
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes1, jobject key1, jint keybytes2, jobject key2, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1buffer_1limit(env, obj, pointer, keybytes1, key1, keybytes2, key2, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1buffer_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes1, jobject key1, jint keybytes2, jobject key2, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_KEYS_BUFFER);
+    auto db = (Database*) pointer;
+    const char* ckey1 = (char*) env->GetDirectBufferAddress(key1);
+    const char* ckey2 = (char*) env->GetDirectBufferAddress(key2);
+    const auto mid = callback_method(env, callback, GET_KEYS_BUFFER_METHOD);
+    ScratchScope scope;
+    ContextGetKeysBuffer cxt = CONTEXT_GET_KEYS_BUFFER;
+    auto status = timed(kv_keys_between, db, ckey1, keybytes1, ckey2, keybytes2, CALLBACK_GET_KEYS_BUFFER, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+const auto CALLBACK_GET_KEYS_BYTEARRAY = [](const char* k, size_t kb, const char* v, size_t vb, void *arg) -> int {
+    stats_bytes(kb);
+    const auto c = ((Context*) arg);
+    const auto ckey = c->env->NewByteArray(kb);
+    c->env->SetByteArrayRegion(ckey, 0, kb, (jbyte*) k);
+    c->env->CallVoidMethod(c->callback, c->mid, ckey);
+    c->env->DeleteLocalRef(ckey);
+    return scan_next(c->env, c->remaining);
+};
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1keys_1bytes_1limit(env, obj, pointer, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1bytes_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_KEYS_BYTES);
+    auto db = (Database*) pointer;
+    const auto mid = callback_method(env, callback, GET_KEYS_BYTEARRAY_METHOD);
+    Context cxt = CONTEXT;
+    auto status = timed(kv_keys_all, db, CALLBACK_GET_KEYS_BYTEARRAY, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1bytes_1limit(env, obj, pointer, key, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1bytes_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_KEYS_BYTES);
+    auto db = (Database*) pointer;
+    ByteArray ckey(env, key);
+    const auto mid = callback_method(env, callback, GET_KEYS_BYTEARRAY_METHOD);
+    Context cxt = CONTEXT;
+    auto status = timed(kv_keys_above, db, ckey.data(), ckey.size(), CALLBACK_GET_KEYS_BYTEARRAY, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1bytes_1limit(env, obj, pointer, key, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1bytes_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_KEYS_BYTES);
+    auto db = (Database*) pointer;
+    ByteArray ckey(env, key);
+    const auto mid = callback_method(env, callback, GET_KEYS_BYTEARRAY_METHOD);
+    Context cxt = CONTEXT;
+    auto status = timed(kv_keys_below, db, ckey.data(), ckey.size(), CALLBACK_GET_KEYS_BYTEARRAY, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key1, jbyteArray key2, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1bytes_1limit(env, obj, pointer, key1, key2, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1bytes_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key1, jbyteArray key2, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_KEYS_BYTES);
+    auto db = (Database*) pointer;
+    ByteArray ckey1(env, key1);
+    ByteArray ckey2(env, key2);
+    const auto mid = callback_method(env, callback, GET_KEYS_BYTEARRAY_METHOD);
+    Context cxt = CONTEXT;
+    auto status = timed(kv_keys_between, db, ckey1.data(), ckey1.size(), ckey2.data(), ckey2.size(), CALLBACK_GET_KEYS_BYTEARRAY, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+const auto CALLBACK_GET_KEYS_STRING = [](const char* k, size_t kb, const char* v, size_t vb, void *arg) -> int {
+    stats_bytes(kb);
+    const auto c = ((Context*) arg);
+    const auto ckey = new_string(c->env, k, kb);
+    if (ckey == NULL) return 1;
+    c->env->CallVoidMethod(c->callback, c->mid, ckey);
+    c->env->DeleteLocalRef(ckey);
+    return scan_next(c->env, c->remaining);
+};
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1string
+        (JNIEnv* env, jobject obj, jlong pointer, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1keys_1string_1limit(env, obj, pointer, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1string_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_KEYS_STRING);
+    auto db = (Database*) pointer;
+    const auto mid = callback_method(env, callback, GET_KEYS_STRING_METHOD);
+    Context cxt = CONTEXT;
+    auto status = timed(kv_keys_all, db, CALLBACK_GET_KEYS_STRING, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1string
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1string_1limit(env, obj, pointer, key, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1string_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_KEYS_STRING);
+    auto db = (Database*) pointer;
+    ByteArray ckey(env, key);
+    const auto mid = callback_method(env, callback, GET_KEYS_STRING_METHOD);
+    Context cxt = CONTEXT;
+    auto status = timed(kv_keys_above, db, ckey.data(), ckey.size(), CALLBACK_GET_KEYS_STRING, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1string
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1string_1limit(env, obj, pointer, key, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1string_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_KEYS_STRING);
+    auto db = (Database*) pointer;
+    ByteArray ckey(env, key);
+    const auto mid = callback_method(env, callback, GET_KEYS_STRING_METHOD);
+    Context cxt = CONTEXT;
+    auto status = timed(kv_keys_below, db, ckey.data(), ckey.size(), CALLBACK_GET_KEYS_STRING, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1string
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key1, jbyteArray key2, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1string_1limit(env, obj, pointer, key1, key2, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1string_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key1, jbyteArray key2, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_KEYS_STRING);
+    auto db = (Database*) pointer;
+    ByteArray ckey1(env, key1);
+    ByteArray ckey2(env, key2);
+    const auto mid = callback_method(env, callback, GET_KEYS_STRING_METHOD);
+    Context cxt = CONTEXT;
+    auto status = timed(kv_keys_between, db, ckey1.data(), ckey1.size(), ckey2.data(), ckey2.size(), CALLBACK_GET_KEYS_STRING, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1count_1all
+        (JNIEnv* env, jobject obj, jlong pointer) {
+    OpTimer timer(STATS_COUNT_ALL);
+    auto db = (Database*) pointer;
+    size_t count;
+    timed(kv_count_all, db, &count);
+
+    return count;
+}
+
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1count_1above_1buffer
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key) {
+    OpTimer timer(STATS_COUNT_BUFFER);
+    auto db = (Database*) pointer;
+    const char* ckey = (char*) env->GetDirectBufferAddress(key);
+    
+    size_t count;
+    timed(kv_count_above, db, ckey, keybytes, &count);
+
+    return count;
+}
+
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1count_1below_1buffer
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key) {
+    OpTimer timer(STATS_COUNT_BUFFER);
+    auto db = (Database*) pointer;
+    const char* ckey = (char*) env->GetDirectBufferAddress(key);
+
+    size_t count;
+    timed(kv_count_below, db, ckey, keybytes, &count);
+
+    return count;
+}
+
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1count_1between_1buffer
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes1, jobject key1, jint keybytes2, jobject key2) {
+    OpTimer timer(STATS_COUNT_BUFFER);
+    auto db = (Database*) pointer;
+    const char* ckey1 = (char*) env->GetDirectBufferAddress(key1);
+    const char* ckey2 = (char*) env->GetDirectBufferAddress(key2);
+    
+    size_t count;
+    timed(kv_count_between, db, ckey1, keybytes1, ckey2, keybytes2, &count);
+
+    return count;
+}
+
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1count_1above_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key) {
+    OpTimer timer(STATS_COUNT_BYTES);
+    auto db = (Database*) pointer;
+    ByteArray ckey(env, key);
+
+    size_t count;
+    timed(kv_count_above, db, ckey.data(), ckey.size(), &count);
+
+    return count;
+}
+
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1count_1below_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key) {
+    OpTimer timer(STATS_COUNT_BYTES);
+    auto db = (Database*) pointer;
+    ByteArray ckey(env, key);
+
+    size_t count;
+    timed(kv_count_below, db, ckey.data(), ckey.size(), &count);
+
+    return count;
+}
+
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1count_1between_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key1, jbyteArray key2) {
+    OpTimer timer(STATS_COUNT_BYTES);
+    auto db = (Database*) pointer;
+    ByteArray ckey1(env, key1);
+    ByteArray ckey2(env, key2);
+
+    size_t count;
+    timed(kv_count_between, db, ckey1.data(), ckey1.size(), ckey2.data(), ckey2.size(), &count);
+
+    return count;
+}
+
+struct ContextGetAllBuffer {
+    JNIEnv* env;
+    jobject callback;
+    jmethodID mid;
+    ScratchLevel* scratch;
+    jlong remaining;
+};
+
+#define CONTEXT_GET_ALL_BUFFER {env, callback, mid, scope.level, limit}
+
+const auto CALLBACK_GET_ALL_BUFFER = [](const char* k, size_t kb, const char* v, size_t vb, void *arg) -> int {
+    stats_bytes(kb + vb);
+    const auto c = ((ContextGetAllBuffer*) arg);
+    if (!scratch_reserve(c->env, c->scratch->key, kb)) return 1;
+    if (!scratch_reserve(c->env, c->scratch->value, vb)) return 1;
+    std::memcpy(c->scratch->key.data, k, kb);
+    std::memcpy(c->scratch->value.data, v, vb);
+    c->env->CallVoidMethod(c->callback, c->mid, kb, c->scratch->key.buffer, vb, c->scratch->value.buffer);
+    return scan_next(c->env, c->remaining);
+};
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1buffer
+        (JNIEnv* env, jobject obj, jlong pointer, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1all_1buffer_1limit(env, obj, pointer, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1buffer_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_BUFFER);
+    auto db = (Database*) pointer;
+    const auto mid = callback_method(env, callback, GET_ALL_BUFFER_METHOD);
+    ScratchScope scope;
+    ContextGetAllBuffer cxt = CONTEXT_GET_ALL_BUFFER;
+    auto status = timed(kv_get_all, db, CALLBACK_GET_ALL_BUFFER, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1buffer
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1above_1buffer_1limit(env, obj, pointer, keybytes, key, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1buffer_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_BUFFER);
+    auto db = (Database*) pointer;
+    const char* ckey = (char*) env->GetDirectBufferAddress(key);
+    const auto mid = callback_method(env, callback, GET_ALL_BUFFER_METHOD);
+    ScratchScope scope;
+    ContextGetAllBuffer cxt = CONTEXT_GET_ALL_BUFFER;
+    auto status = timed(kv_get_above, db, ckey, keybytes, CALLBACK_GET_ALL_BUFFER, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1buffer
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1below_1buffer_1limit(env, obj, pointer, keybytes, key, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1buffer_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_BUFFER);
+    auto db = (Database*) pointer;
+    const char* ckey = (char*) env->GetDirectBufferAddress(key);
+    const auto mid = callback_method(env, callback, GET_ALL_BUFFER_METHOD);
+    ScratchScope scope;
+    ContextGetAllBuffer cxt = CONTEXT_GET_ALL_BUFFER;
+    auto status = timed(kv_get_below, db, ckey, keybytes, CALLBACK_GET_ALL_BUFFER,&cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1buffer
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes1, jobject key1, jint keybytes2, jobject key2, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1between_1buffer_1limit(env, obj, pointer, keybytes1, key1, keybytes2, key2, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1buffer_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes1, jobject key1, jint keybytes2, jobject key2, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_BUFFER);
+    auto db = (Database*) pointer;
+    const char* ckey1 = (char*) env->GetDirectBufferAddress(key1);
+    const char* ckey2 = (char*) env->GetDirectBufferAddress(key2);
+    const auto mid = callback_method(env, callback, GET_ALL_BUFFER_METHOD);
+    ScratchScope scope;
+    ContextGetAllBuffer cxt = CONTEXT_GET_ALL_BUFFER;
+    auto status = timed(kv_get_between, db, ckey1, keybytes1, ckey2, keybytes2, CALLBACK_GET_ALL_BUFFER, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+const auto CALLBACK_GET_ALL_BYTEARRAY = [](const char* k, size_t kb, const char* v, size_t vb, void *arg) -> int {
+    stats_bytes(kb + vb);
+    const auto c = ((Context*) arg);
+    const auto ckey = c->env->NewByteArray(kb);
+    c->env->SetByteArrayRegion(ckey, 0, kb, (jbyte*) k);
+    const auto cvalue = c->env->NewByteArray(vb);
+    c->env->SetByteArrayRegion(cvalue, 0, vb, (jbyte*) v);
+    c->env->CallVoidMethod(c->callback, c->mid, ckey, cvalue);
+    c->env->DeleteLocalRef(ckey);
+    c->env->DeleteLocalRef(cvalue);
+    return scan_next(c->env, c->remaining);
+};
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1all_1bytes_1limit(env, obj, pointer, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1bytes_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_BYTES);
+    auto db = (Database*) pointer;
+    const auto mid = callback_method(env, callback, GET_ALL_BYTEARRAY_METHOD);
+    Context cxt = CONTEXT;
+    auto status = timed(kv_get_all, db, CALLBACK_GET_ALL_BYTEARRAY, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1above_1bytes_1limit(env, obj, pointer, key, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1bytes_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_BYTES);
+    auto db = (Database*) pointer;
+    ByteArray ckey(env, key);
+    const auto mid = callback_method(env, callback, GET_ALL_BYTEARRAY_METHOD);
+    Context cxt = CONTEXT;
+    auto status = timed(kv_get_above, db, ckey.data(), ckey.size(), CALLBACK_GET_ALL_BYTEARRAY, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1below_1bytes_1limit(env, obj, pointer, key, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1bytes_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_BYTES);
+    auto db = (Database*) pointer;
+    ByteArray ckey(env, key);
+    const auto mid = callback_method(env, callback, GET_ALL_BYTEARRAY_METHOD);
+    Context cxt = CONTEXT;
+    auto status = timed(kv_get_below, db, ckey.data(), ckey.size(), CALLBACK_GET_ALL_BYTEARRAY, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key1, jbyteArray key2, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1between_1bytes_1limit(env, obj, pointer, key1, key2, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1bytes_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key1, jbyteArray key2, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_BYTES);
+    auto db = (Database*) pointer;
+    ByteArray ckey1(env, key1);
+    ByteArray ckey2(env, key2);
+    const auto mid = callback_method(env, callback, GET_ALL_BYTEARRAY_METHOD);
+    Context cxt = CONTEXT;
+    auto status = timed(kv_get_between, db, ckey1.data(), ckey1.size(), ckey2.data(), ckey2.size(), CALLBACK_GET_ALL_BYTEARRAY, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+const auto CALLBACK_GET_ALL_STRING = [](const char* k, size_t kb, const char* v, size_t vb, void *arg) -> int {
+    stats_bytes(kb + vb);
+    const auto c = ((Context*) arg);
+    const auto ckey = new_string(c->env, k, kb);
+    const auto cvalue = ckey != NULL ? new_string(c->env, v, vb) : NULL;
+    if (cvalue == NULL) {
+        if (ckey != NULL) c->env->DeleteLocalRef(ckey);
+        return 1;
+    }
+    c->env->CallVoidMethod(c->callback, c->mid, ckey, cvalue);
+    c->env->DeleteLocalRef(ckey);
+    c->env->DeleteLocalRef(cvalue);
+    return scan_next(c->env, c->remaining);
+};
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1string
+        (JNIEnv* env, jobject obj, jlong pointer, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1all_1string_1limit(env, obj, pointer, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1string_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_STRING);
+    auto db = (Database*) pointer;
+    const auto mid = callback_method(env, callback, GET_ALL_STRING_METHOD);
+    Context cxt = CONTEXT;
+    auto status = timed(kv_get_all, db, CALLBACK_GET_ALL_STRING, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1string
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1above_1string_1limit(env, obj, pointer, key, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1string_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_STRING);
+    auto db = (Database*) pointer;
+    ByteArray ckey(env, key);
+    const auto mid = callback_method(env, callback, GET_ALL_STRING_METHOD);
+    Context cxt = CONTEXT;
+    auto status = timed(kv_get_above, db, ckey.data(), ckey.size(), CALLBACK_GET_ALL_STRING, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1string
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1below_1string_1limit(env, obj, pointer, key, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1string_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_STRING);
+    auto db = (Database*) pointer;
+    ByteArray ckey(env, key);
+    const auto mid = callback_method(env, callback, GET_ALL_STRING_METHOD);
+    Context cxt = CONTEXT;
+    auto status = timed(kv_get_below, db, ckey.data(), ckey.size(), CALLBACK_GET_ALL_STRING, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1string
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key1, jbyteArray key2, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1between_1string_1limit(env, obj, pointer, key1, key2, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1string_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key1, jbyteArray key2, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_STRING);
+    auto db = (Database*) pointer;
+    ByteArray ckey1(env, key1);
+    ByteArray ckey2(env, key2);
+    const auto mid = callback_method(env, callback, GET_ALL_STRING_METHOD);
+    Context cxt = CONTEXT;
+    auto status = timed(kv_get_between, db, ckey1.data(), ckey1.size(), ckey2.data(), ckey2.size(), CALLBACK_GET_ALL_STRING, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+/*
+ * Prefix scans visit the keys starting with a prefix: the prefix itself,
+ * found with an exact get, then the keys between the prefix and its
+ * successor. The successor drops trailing 0xFF bytes and increments the
+ * last remaining one; a prefix of only 0xFF bytes has none, and every key
+ * above it starts with it.
+ */
+static bool prefix_successor(const char* prefix, size_t bytes, std::string& successor) {
+    while (bytes > 0 && (unsigned char) prefix[bytes - 1] == 0xFF) bytes--;
+    if (bytes == 0) return false;
+    successor.assign(prefix, bytes);
+    successor[bytes - 1] = (char) ((unsigned char) successor[bytes - 1] + 1);
+    return true;
+}
+
+struct ContextPrefixExact {
+    pmemkv_get_kv_callback* callback;
+    void* arg;
+    const char* key;
+    size_t keybytes;
+    int result;
+};
+
+const auto CALLBACK_PREFIX_EXACT = [](const char* v, size_t vb, void *arg) {
+    const auto c = ((ContextPrefixExact*) arg);
+    c->result = c->callback(c->key, c->keybytes, v, vb, c->arg);
+};
+
+/* Key-only scans take the kv_keys_* path, so values are never decoded. */
+static int scan_prefix(Database* db, const char* prefix, size_t bytes, bool keys_only,
+        pmemkv_get_kv_callback* callback, void* arg) {
+    const auto all = keys_only ? kv_keys_all : kv_get_all;
+    const auto above = keys_only ? kv_keys_above : kv_get_above;
+    const auto between = keys_only ? kv_keys_between : kv_get_between;
+    if (bytes == 0) return timed(all, db, callback, arg);
+    ContextPrefixExact exact = {callback, arg, prefix, bytes, 0};
+    int status;
+    if (keys_only) {
+        status = timed(kv_exists, db, prefix, bytes);
+        if (status == PMEMKV_STATUS_OK) exact.result = callback(prefix, bytes, "", 0, arg);
+    } else {
+        status = kv_get(db, prefix, bytes, CALLBACK_PREFIX_EXACT, &exact);
+    }
+    if (status != PMEMKV_STATUS_OK && status != PMEMKV_STATUS_NOT_FOUND) return status;
+    if (exact.result != 0) return PMEMKV_STATUS_STOPPED_BY_CB;
+    std::string successor;
+    if (!prefix_successor(prefix, bytes, successor))
+        return timed(above, db, prefix, bytes, callback, arg);
+    return timed(between, db, prefix, bytes, successor.data(), successor.size(), callback, arg);
+}
+
+static int count_prefix(Database* db, const char* prefix, size_t bytes, size_t* count) {
+    *count = 0;
+    if (bytes == 0) return timed(kv_count_all, db, count);
+    std::string successor;
+    int status;
+    if (prefix_successor(prefix, bytes, successor))
+        status = timed(kv_count_between, db, prefix, bytes, successor.data(), successor.size(), count);
+    else
+        status = timed(kv_count_above, db, prefix, bytes, count);
+    if (status != PMEMKV_STATUS_OK) return status;
+    status = timed(kv_exists, db, prefix, bytes);
+    if (status == PMEMKV_STATUS_OK) ++*count;
+    return status == PMEMKV_STATUS_NOT_FOUND ? PMEMKV_STATUS_OK : status;
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1prefix_1buffer
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_KEYS_BUFFER);
+    auto db = (Database*) pointer;
+    const char* ckey = (char*) env->GetDirectBufferAddress(key);
+    const auto mid = callback_method(env, callback, GET_KEYS_BUFFER_METHOD);
+    ScratchScope scope;
+    ContextGetKeysBuffer cxt = CONTEXT_GET_KEYS_BUFFER;
+    auto status = scan_prefix(db, ckey, keybytes, true, CALLBACK_GET_KEYS_BUFFER, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1prefix_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_KEYS_BYTES);
+    auto db = (Database*) pointer;
+    ByteArray ckey(env, key);
+    const auto mid = callback_method(env, callback, GET_KEYS_BYTEARRAY_METHOD);
+    Context cxt = CONTEXT;
+    auto status = scan_prefix(db, ckey.data(), ckey.size(), true, CALLBACK_GET_KEYS_BYTEARRAY, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1prefix_1buffer
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_BUFFER);
+    auto db = (Database*) pointer;
+    const char* ckey = (char*) env->GetDirectBufferAddress(key);
+    const auto mid = callback_method(env, callback, GET_ALL_BUFFER_METHOD);
+    ScratchScope scope;
+    ContextGetAllBuffer cxt = CONTEXT_GET_ALL_BUFFER;
+    auto status = scan_prefix(db, ckey, keybytes, false, CALLBACK_GET_ALL_BUFFER, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1prefix_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_BYTES);
+    auto db = (Database*) pointer;
+    ByteArray ckey(env, key);
+    const auto mid = callback_method(env, callback, GET_ALL_BYTEARRAY_METHOD);
     Context cxt = CONTEXT;
-    auto status = pmemkv_get_below(engine, (char*) ckey, ckeybytes, CALLBACK_GET_ALL_BYTEARRAY, &cxt);
-    env->ReleaseByteArrayElements(key, ckey, JNI_ABORT);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
+    auto status = scan_prefix(db, ckey.data(), ckey.size(), false, CALLBACK_GET_ALL_BYTEARRAY, &cxt);
+    if (scan_failed(status)) throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1count_1prefix_1buffer
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key) {
+    OpTimer timer(STATS_COUNT_BUFFER);
+    auto db = (Database*) pointer;
+    const char* ckey = (char*) env->GetDirectBufferAddress(key);
+    size_t count;
+    if (count_prefix(db, ckey, keybytes, &count) != PMEMKV_STATUS_OK) {
+        throw_exception(env, pmemkv_errormsg());
+        return 0;
+    }
+    return count;
+}
+
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1count_1prefix_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key) {
+    OpTimer timer(STATS_COUNT_BYTES);
+    auto db = (Database*) pointer;
+    size_t count;
+    int status;
+    {
+        ByteArray ckey(env, key);
+        status = count_prefix(db, ckey.data(), ckey.size(), &count);
+    }
+    if (status != PMEMKV_STATUS_OK) {
+        throw_exception(env, pmemkv_errormsg());
+        return 0;
+    }
+    return count;
+}
+
+/*
+ * Batched scans pack records into the caller's direct buffer as
+ * [int32 keybytes][int32 valuebytes][key][value] (native byte order) and
+ * call process(count, bytes) once per full batch instead of once per record.
+ */
+struct ContextGetAllBatch {
+    JNIEnv* env;
+    jobject callback;
+    jmethodID mid;
+    char* batch;
+    size_t batchbytes;
+    size_t used;
+    jint count;
+    jlong remaining;
+};
+
+#define CONTEXT_GET_ALL_BATCH {env, callback, mid, cbatch, (size_t) batchbytes, 0, 0, limit}
+
+static bool flush_batch(ContextGetAllBatch* c) {
+    if (c->count == 0) return true;
+    c->env->CallVoidMethod(c->callback, c->mid, c->count, (jint) c->used);
+    c->count = 0;
+    c->used = 0;
+    return !c->env->ExceptionCheck();
+}
+
+const auto CALLBACK_GET_ALL_BATCH = [](const char* k, size_t kb, const char* v, size_t vb, void *arg) -> int {
+    stats_bytes(kb + vb);
+    const auto c = ((ContextGetAllBatch*) arg);
+    const size_t recordbytes = 2 * sizeof(int32_t) + kb + vb;
+    if (recordbytes > c->batchbytes - c->used) {
+        if (!flush_batch(c)) return 1;
+        if (recordbytes > c->batchbytes) {
+            throw_exception(c->env, "ByteBuffer is too small");
+            return 1;
+        }
+    }
+    char* record = c->batch + c->used;
+    write_int32(record, kb);
+    write_int32(record + sizeof(int32_t), vb);
+    std::memcpy(record + 2 * sizeof(int32_t), k, kb);
+    std::memcpy(record + 2 * sizeof(int32_t) + kb, v, vb);
+    c->used += recordbytes;
+    c->count++;
+    return scan_next(c->env, c->remaining);
+};
+
+static void finish_batch(JNIEnv* env, ContextGetAllBatch* cxt, int status) {
+    if (env->ExceptionCheck()) return;
+    if (scan_failed(status)) {
+        throw_exception(env, pmemkv_errormsg());
+        return;
+    }
+    flush_batch(cxt);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1batch
+        (JNIEnv* env, jobject obj, jlong pointer, jint batchbytes, jobject batch, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1all_1batch_1limit(env, obj, pointer, batchbytes, batch, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1batch_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jint batchbytes, jobject batch, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_BATCH);
+    auto db = (Database*) pointer;
+    const auto cbatch = direct_buffer(env, batch, batchbytes);
+    if (cbatch == nullptr) return;
+    const auto mid = callback_method(env, callback, GET_ALL_BATCH_METHOD);
+    ContextGetAllBatch cxt = CONTEXT_GET_ALL_BATCH;
+    auto status = timed(kv_get_all, db, CALLBACK_GET_ALL_BATCH, &cxt);
+    finish_batch(env, &cxt, status);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1batch
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jint batchbytes, jobject batch, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1above_1batch_1limit(env, obj, pointer, keybytes, key, batchbytes, batch, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1batch_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jint batchbytes, jobject batch, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_BATCH);
+    auto db = (Database*) pointer;
+    const char* ckey = (char*) env->GetDirectBufferAddress(key);
+    const auto cbatch = direct_buffer(env, batch, batchbytes);
+    if (cbatch == nullptr) return;
+    const auto mid = callback_method(env, callback, GET_ALL_BATCH_METHOD);
+    ContextGetAllBatch cxt = CONTEXT_GET_ALL_BATCH;
+    auto status = timed(kv_get_above, db, ckey, keybytes, CALLBACK_GET_ALL_BATCH, &cxt);
+    finish_batch(env, &cxt, status);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1batch
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jint batchbytes, jobject batch, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1below_1batch_1limit(env, obj, pointer, keybytes, key, batchbytes, batch, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1batch_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jint batchbytes, jobject batch, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_BATCH);
+    auto db = (Database*) pointer;
+    const char* ckey = (char*) env->GetDirectBufferAddress(key);
+    const auto cbatch = direct_buffer(env, batch, batchbytes);
+    if (cbatch == nullptr) return;
+    const auto mid = callback_method(env, callback, GET_ALL_BATCH_METHOD);
+    ContextGetAllBatch cxt = CONTEXT_GET_ALL_BATCH;
+    auto status = timed(kv_get_below, db, ckey, keybytes, CALLBACK_GET_ALL_BATCH, &cxt);
+    finish_batch(env, &cxt, status);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1batch
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes1, jobject key1, jint keybytes2, jobject key2, jint batchbytes, jobject batch, jobject callback) {
+    Java_io_pmem_pmemkv_Database_database_1get_1between_1batch_1limit(env, obj, pointer, keybytes1, key1, keybytes2, key2, batchbytes, batch, 0, callback);
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1batch_1limit
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes1, jobject key1, jint keybytes2, jobject key2, jint batchbytes, jobject batch, jlong limit, jobject callback) {
+    OpTimer timer(STATS_SCAN_BATCH);
+    auto db = (Database*) pointer;
+    const char* ckey1 = (char*) env->GetDirectBufferAddress(key1);
+    const char* ckey2 = (char*) env->GetDirectBufferAddress(key2);
+    const auto cbatch = direct_buffer(env, batch, batchbytes);
+    if (cbatch == nullptr) return;
+    const auto mid = callback_method(env, callback, GET_ALL_BATCH_METHOD);
+    ContextGetAllBatch cxt = CONTEXT_GET_ALL_BATCH;
+    auto status = timed(kv_get_between, db, ckey1, keybytes1, ckey2, keybytes2, CALLBACK_GET_ALL_BATCH, &cxt);
+    finish_batch(env, &cxt, status);
+}
+
+/*
+ * Parallel scans split (key1, key2) into one sub-range per batch buffer and
+ * scan them concurrently on native threads, each delivering to its own
+ * callback. Split points are found by bisecting, with pmemkv_count_between,
+ * the space of the 8 bytes that follow the common prefix of key1 and key2,
+ * so keys which only differ further on yield fewer non-empty partitions
+ * than requested. Sub-range i covers
+ * [split(i), split(i + 1)), which requires an engine that supports
+ * concurrent readers. Every batch must be a direct buffer with a callback;
+ * otherwise the call throws before any thread is started.
+ */
+#define PARALLEL_SPLIT_BYTES 8
+
+static uint64_t key_prefix(const char* k, size_t kb, size_t offset) {
+    uint64_t result = 0;
+    for (size_t i = offset; i < offset + PARALLEL_SPLIT_BYTES; i++)
+        result = (result << 8) | (i < kb ? (uint8_t) k[i] : 0);
+    return result;
+}
+
+static std::string prefix_key(const std::string& common, uint64_t prefix) {
+    std::string result = common + std::string(PARALLEL_SPLIT_BYTES, '\0');
+    for (size_t i = result.size(); i > common.size(); i--, prefix >>= 8)
+        result[i - 1] = (char) (prefix & 0xFF);
+    return result;
+}
+
+struct Partition {
+    Database* db;
+    std::string lower;
+    bool inclusive;
+    std::string upper;
+    char* cbatch;
+    jlong batchbytes;
+    jobject callback;
+    jmethodID mid;
+    std::string error;
+    jthrowable thrown;
+};
+
+struct ContextGetPartitionLower {
+    ContextGetAllBatch* cxt;
+    const std::string* key;
+};
+
+const auto CALLBACK_GET_PARTITION_LOWER = [](const char* v, size_t vb, void *arg) {
+    const auto c = ((ContextGetPartitionLower*) arg);
+    CALLBACK_GET_ALL_BATCH(c->key->data(), c->key->size(), v, vb, c->cxt);
+};
+
+static void scan_partition(JavaVM* vm, Partition* p) {
+    JNIEnv* env;
+    JavaVMAttachArgs args = {JNI_VERSION_1_6, (char*) "pmemkv-scan", NULL};
+    if (vm->AttachCurrentThread((void**) &env, &args) != JNI_OK) {
+        p->error = "Cannot attach scan thread";
+        return;
+    }
+
+    const auto cbatch = p->cbatch;
+    const auto batchbytes = p->batchbytes;
+    const auto callback = p->callback;
+    const auto mid = p->mid;
+    const jlong limit = 0;
+    ContextGetAllBatch cxt = CONTEXT_GET_ALL_BATCH;
+    int status = PMEMKV_STATUS_OK;
+    if (p->inclusive) {
+        ContextGetPartitionLower lower = {&cxt, &p->lower};
+        status = kv_get(p->db, p->lower.data(), p->lower.size(), CALLBACK_GET_PARTITION_LOWER, &lower);
+        if (status == PMEMKV_STATUS_NOT_FOUND) status = PMEMKV_STATUS_OK;
+    }
+    if (status == PMEMKV_STATUS_OK && !env->ExceptionCheck())
+        status = kv_get_between(p->db, p->lower.data(), p->lower.size(), p->upper.data(), p->upper.size(),
+                CALLBACK_GET_ALL_BATCH, &cxt);
+    if (status == PMEMKV_STATUS_OK && !env->ExceptionCheck())
+        flush_batch(&cxt);
+
+    if (env->ExceptionCheck()) {
+        p->thrown = (jthrowable) env->NewGlobalRef(env->ExceptionOccurred());
+        env->ExceptionClear();
+    } else if (status != PMEMKV_STATUS_OK) {
+        p->error = pmemkv_errormsg();
+    }
+    vm->DetachCurrentThread();
+}
+
+static std::vector<std::string> split_range(Database* db, const char* k1, size_t kb1, const char* k2, size_t kb2, size_t partitions) {
+    std::vector<std::string> splits;
+    size_t total;
+    if (partitions < 2 || kv_count_between(db, k1, kb1, k2, kb2, &total) != PMEMKV_STATUS_OK)
+        return splits;
+
+    size_t offset = 0;
+    while (offset < kb1 && offset < kb2 && k1[offset] == k2[offset]) offset++;
+    const std::string common(k1, offset);
+    const size_t tolerance = total / (4 * partitions);
+    uint64_t low = key_prefix(k1, kb1, offset);
+    const uint64_t high = key_prefix(k2, kb2, offset);
+    for (size_t i = 1; i < partitions && low < high; i++) {
+        const size_t target = total * i / partitions;
+        uint64_t lo = low, hi = high;
+        while (lo < hi) {
+            const uint64_t mid = lo + (hi - lo) / 2;
+            const auto key = prefix_key(common, mid);
+            size_t count;
+            if (kv_count_between(db, k1, kb1, key.data(), key.size(), &count) != PMEMKV_STATUS_OK)
+                return splits;
+            if (count + tolerance < target) lo = mid + 1;
+            else if (count > target + tolerance) hi = mid;
+            else lo = hi = mid;
+        }
+        const auto split = prefix_key(common, lo);
+        if (compare_keys(split.data(), split.size(), k1, kb1) > 0 && compare_keys(split.data(), split.size(), k2, kb2) < 0
+                && (splits.empty() || splits.back() != split))
+            splits.push_back(split);
+        low = lo;
+    }
+    return splits;
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1parallel
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes1, jobject key1, jint keybytes2, jobject key2, jobjectArray batches, jobjectArray callbacks) {
+    OpTimer timer(STATS_SCAN_PARALLEL);
+    auto db = (Database*) pointer;
+    const char* ckey1 = (char*) env->GetDirectBufferAddress(key1);
+    const char* ckey2 = (char*) env->GetDirectBufferAddress(key2);
+    const auto count = env->GetArrayLength(batches);
+    JavaVM* vm;
+    if (count == 0 || env->GetArrayLength(callbacks) != count || env->GetJavaVM(&vm) != JNI_OK) {
+        throw_exception(env, "Invalid partitions");
+        return;
+    }
+
+    // every partition is checked up front, so that none fails alone
+    std::vector<char*> cbatches(count);
+    std::vector<jlong> batchbytes(count);
+    std::vector<jmethodID> mids(count);
+    for (jsize i = 0; i < count; i++) {
+        const auto batch = env->GetObjectArrayElement(batches, i);
+        const auto callback = env->GetObjectArrayElement(callbacks, i);
+        if (batch == NULL || callback == NULL) {
+            throw_exception(env, "Invalid partitions");
+        } else {
+            batchbytes[i] = env->GetDirectBufferCapacity(batch);
+            cbatches[i] = direct_buffer(env, batch, batchbytes[i]);
+            if (cbatches[i] != nullptr) mids[i] = callback_method(env, callback, GET_ALL_BATCH_METHOD);
+        }
+        env->DeleteLocalRef(batch);
+        env->DeleteLocalRef(callback);
+        if (env->ExceptionCheck() || mids[i] == nullptr) return;
+    }
+
+    const auto splits = split_range(db, ckey1, keybytes1, ckey2, keybytes2, count);
+    std::vector<Partition> partitions(splits.size() + 1);
+    for (size_t i = 0; i < partitions.size(); i++) {
+        auto& p = partitions[i];
+        p.db = db;
+        p.lower = i == 0 ? std::string(ckey1, keybytes1) : splits[i - 1];
+        p.inclusive = i > 0;
+        p.upper = i == splits.size() ? std::string(ckey2, keybytes2) : splits[i];
+        p.cbatch = cbatches[i];
+        p.batchbytes = batchbytes[i];
+        p.mid = mids[i];
+        const auto callback = env->GetObjectArrayElement(callbacks, i);
+        p.callback = env->NewGlobalRef(callback);
+        p.thrown = nullptr;
+        env->DeleteLocalRef(callback);
+    }
+
+    std::vector<std::thread> threads;
+    for (auto& p : partitions) threads.emplace_back(scan_partition, vm, &p);
+    for (auto& thread : threads) thread.join();
+
+    for (auto& p : partitions) {
+        if (p.thrown != nullptr) {
+            if (!env->ExceptionCheck()) env->Throw(p.thrown);
+            env->DeleteGlobalRef(p.thrown);
+        } else if (!p.error.empty()) {
+            throw_exception(env, p.error.c_str());
+        }
+        env->DeleteGlobalRef(p.callback);
+    }
+}
+
+/*
+ * A cursor pages through a key range: each database_cursor_next call fills
+ * a direct buffer with up to 'count' records, laid out as in the batch
+ * scans, and resumes just after the last key it returned. The last key is
+ * also the continuation token: opening a new cursor on it, not inclusive,
+ * continues where the old one stopped. A cursor must be used by one thread
+ * at a time and closed before the database is stopped.
+ *
+ * Every page after the first is read with get_above or get_between, so
+ * paging needs a sorted engine: on an engine without those, such as cmap,
+ * the second call throws the engine's "not supported" error.
+ */
+struct Cursor {
+    Database* db;
+    std::string lower;
+    bool has_lower;
+    bool inclusive;
+    std::string upper;
+    bool has_upper;
+    bool done;
+};
+
+struct ContextCursor {
+    char* batch;
+    size_t batchbytes;
+    size_t used;
+    size_t last;
+    jint count;
+    jint limit;
+    bool full;
+};
+
+const auto CALLBACK_CURSOR = [](const char* k, size_t kb, const char* v, size_t vb, void *arg) -> int {
+    stats_bytes(kb + vb);
+    const auto c = ((ContextCursor*) arg);
+    const size_t recordbytes = 2 * sizeof(int32_t) + kb + vb;
+    if (recordbytes > c->batchbytes - c->used) {
+        c->full = true;
+        return 1;
+    }
+    char* record = c->batch + c->used;
+    write_int32(record, kb);
+    write_int32(record + sizeof(int32_t), vb);
+    std::memcpy(record + 2 * sizeof(int32_t), k, kb);
+    std::memcpy(record + 2 * sizeof(int32_t) + kb, v, vb);
+    c->last = c->used;
+    c->used += recordbytes;
+    return ++c->count == c->limit;
+};
+
+struct ContextCursorLower {
+    ContextCursor* cxt;
+    const std::string* key;
+};
+
+const auto CALLBACK_CURSOR_LOWER = [](const char* v, size_t vb, void *arg) {
+    const auto c = ((ContextCursorLower*) arg);
+    CALLBACK_CURSOR(c->key->data(), c->key->size(), v, vb, c->cxt);
+};
+
+/*
+ * Opens a cursor on the keys from 'start' (null for the first key, and
+ * exclusive unless 'inclusive') up to 'end' (null for no upper bound,
+ * always exclusive).
+ */
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1cursor_1open
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray start, jboolean inclusive, jbyteArray end) {
+    auto cursor = new Cursor{(Database*) pointer, "", start != NULL, inclusive == JNI_TRUE, "", end != NULL, false};
+    if (start != NULL) {
+        ByteArray cstart(env, start);
+        cursor->lower.assign(cstart.data(), cstart.size());
+    }
+    if (end != NULL) {
+        ByteArray cend(env, end);
+        cursor->upper.assign(cend.data(), cend.size());
+    }
+    return (jlong) cursor;
+}
+
+/*
+ * Fills 'batch' with the next records and returns how many were written,
+ * or 0 once the range is exhausted. Stops early when the next record does
+ * not fit; throws if not even one record fits, or if 'batch' is not a
+ * direct buffer holding 'batchbytes'. Resuming after the first page needs
+ * an engine with get_above and get_between (see Cursor).
+ */
+extern "C" JNIEXPORT jint JNICALL Java_io_pmem_pmemkv_Database_database_1cursor_1next
+        (JNIEnv* env, jobject obj, jlong pointer, jint count, jint batchbytes, jobject batch) {
+    OpTimer timer(STATS_CURSOR_NEXT);
+    auto cursor = (Cursor*) pointer;
+    const auto cbatch = direct_buffer(env, batch, batchbytes);
+    if (cbatch == nullptr || cursor->done || count <= 0) return 0;
+    auto db = cursor->db;
+    ContextCursor cxt = {cbatch, (size_t) batchbytes, 0, 0, 0, count, false};
+
+    int status = PMEMKV_STATUS_OK;
+    if (cursor->has_lower && cursor->inclusive) {
+        ContextCursorLower lower = {&cxt, &cursor->lower};
+        status = kv_get(db, cursor->lower.data(), cursor->lower.size(), CALLBACK_CURSOR_LOWER, &lower);
+        if (status == PMEMKV_STATUS_NOT_FOUND) status = PMEMKV_STATUS_OK;
+    }
+    if (status == PMEMKV_STATUS_OK && cxt.count < count && !cxt.full) {
+        const auto& l = cursor->lower;
+        const auto& u = cursor->upper;
+        if (cursor->has_lower && cursor->has_upper)
+            status = timed(kv_get_between, db, l.data(), l.size(), u.data(), u.size(), CALLBACK_CURSOR, &cxt);
+        else if (cursor->has_lower)
+            status = timed(kv_get_above, db, l.data(), l.size(), CALLBACK_CURSOR, &cxt);
+        else if (cursor->has_upper)
+            status = timed(kv_get_below, db, u.data(), u.size(), CALLBACK_CURSOR, &cxt);
+        else
+            status = timed(kv_get_all, db, CALLBACK_CURSOR, &cxt);
+    }
+    if (scan_failed(status)) {
+        throw_exception(env, pmemkv_errormsg());
+        return 0;
+    }
+    if (cxt.full && cxt.count == 0) {
+        throw_exception(env, "ByteBuffer is too small");
+        return 0;
+    }
+
+    if (cxt.count > 0) {
+        const char* last = cxt.batch + cxt.last;
+        cursor->lower.assign(last + 2 * sizeof(int32_t), read_int32(last));
+        cursor->has_lower = true;
+        cursor->inclusive = false;
+    }
+    cursor->done = !cxt.full && cxt.count < count;
+    return cxt.count;
 }
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1bytes
-        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key1, jbyteArray key2, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto ckey1 = env->GetByteArrayElements(key1, NULL);
-    const auto ckeybytes1 = env->GetArrayLength(key1);
-    const auto ckey2 = env->GetByteArrayElements(key2, NULL);
-    const auto ckeybytes2 = env->GetArrayLength(key2);
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_ALL_BYTEARRAY);
-    Context cxt = CONTEXT;
-    auto status = pmemkv_get_between(engine, (char*) ckey1, ckeybytes1, (char*) ckey2, ckeybytes2, CALLBACK_GET_ALL_BYTEARRAY, &cxt);
-    env->ReleaseByteArrayElements(key1, ckey1, JNI_ABORT);
-    env->ReleaseByteArrayElements(key2, ckey2, JNI_ABORT);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
+/*
+ * Returns the continuation token, the last key returned so far, or null if
+ * no record has been returned yet.
+ */
+extern "C" JNIEXPORT jbyteArray JNICALL Java_io_pmem_pmemkv_Database_database_1cursor_1key
+        (JNIEnv* env, jobject obj, jlong pointer) {
+    auto cursor = (Cursor*) pointer;
+    if (!cursor->has_lower || cursor->inclusive) return NULL;
+    const auto result = env->NewByteArray(cursor->lower.size());
+    env->SetByteArrayRegion(result, 0, cursor->lower.size(), (jbyte*) cursor->lower.data());
+    return result;
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1cursor_1close
+        (JNIEnv* env, jobject obj, jlong pointer) {
+    delete (Cursor*) pointer;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1exists_1buffer
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key) {
+    OpTimer timer(STATS_EXISTS_BUFFER);
+    auto db = (Database*) pointer;
+    const char* ckey = (char*) env->GetDirectBufferAddress(key);
+    auto status = db->exists(ckey, keybytes);
+    if (status != PMEMKV_STATUS_OK && status != PMEMKV_STATUS_NOT_FOUND)
+        throw_exception(env, pmemkv_errormsg());
+    return status == PMEMKV_STATUS_OK;
+
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1exists_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key) {
+    OpTimer timer(STATS_EXISTS_BYTES);
+    auto db = (Database*) pointer;
+    ByteArray ckey(env, key);
+    return db->exists(ckey.data(), ckey.size()) == PMEMKV_STATUS_OK;
+}
+
+struct ContextGetBuffer {
+    JNIEnv* env;
+    int valuebytes;
+    jobject value;
+    jint result;
+};
+
+#define CONTEXT_GET_BUFFER {env, valuebytes, value, 0}
+
+const auto CALLBACK_GET_BUFFER = [](const char* v, size_t vb, void *arg) {
+    stats_bytes(vb);
+    const auto c = ((ContextGetBuffer*) arg);
+    if (vb > c->valuebytes) {
+        throw_exception(c->env, "ByteBuffer is too small");
+    } else {
+        char* cvalue = (char*) c->env->GetDirectBufferAddress(c->value);
+        std::memcpy(cvalue, v, vb);
+        c->result = vb;
+    }
+};
+
+extern "C" JNIEXPORT jint JNICALL Java_io_pmem_pmemkv_Database_database_1get_1buffer
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jint valuebytes, jobject value) {
+    OpTimer timer(STATS_GET_BUFFER);
+    auto db = (Database*) pointer;
+    const char* ckey = (char*) env->GetDirectBufferAddress(key);
+    ContextGetBuffer cxt = CONTEXT_GET_BUFFER;
+    auto status = db->get(ckey, keybytes, CALLBACK_GET_BUFFER, &cxt);
+    if (status != PMEMKV_STATUS_OK && status != PMEMKV_STATUS_NOT_FOUND)
+        throw_exception(env, pmemkv_errormsg());
+    return cxt.result;
+}
+
+#define GET_MANY_ENTRY_BYTES (3 * sizeof(int32_t))
+#define GET_MANY_STATUS_TOO_SMALL (-1)
+
+struct ContextGetMany {
+    char* values;
+    size_t valuebytes;
+    size_t used;
+    char* entry;
+    bool overflow;
+};
+
+const auto CALLBACK_GET_MANY = [](const char* v, size_t vb, void *arg) {
+    stats_bytes(vb);
+    const auto c = ((ContextGetMany*) arg);
+    if (vb > c->valuebytes - c->used) {
+        c->overflow = true;
+        write_int32(c->entry + sizeof(int32_t), vb);
+        write_int32(c->entry + 2 * sizeof(int32_t), 0);
+    } else {
+        std::memcpy(c->values + c->used, v, vb);
+        write_int32(c->entry + sizeof(int32_t), vb);
+        write_int32(c->entry + 2 * sizeof(int32_t), c->used);
+        c->used += vb;
+    }
+};
+
+/*
+ * Looks up 'count' keys packed into 'keys' as [int32 keybytes][key] records
+ * (native byte order) and fills 'values' with a table of 'count' entries
+ * {int32 status, int32 length, int32 offset} followed by the packed values.
+ * Offsets are relative to the start of 'values'. A value which does not fit
+ * in the remaining space is reported with GET_MANY_STATUS_TOO_SMALL and its
+ * required length, and the lookup continues with the next key.
+ * Returns the number of bytes of 'values' used.
+ */
+extern "C" JNIEXPORT jint JNICALL Java_io_pmem_pmemkv_Database_database_1get_1many_1buffer
+        (JNIEnv* env, jobject obj, jlong pointer, jint count, jint keysbytes, jobject keys, jint valuesbytes, jobject values) {
+    OpTimer timer(STATS_GET_MANY_BUFFER);
+    auto db = (Database*) pointer;
+    const char* ckeys = (char*) env->GetDirectBufferAddress(keys);
+    char* cvalues = (char*) env->GetDirectBufferAddress(values);
+    if (ckeys == nullptr || keysbytes < 0 || keysbytes > env->GetDirectBufferCapacity(keys)) {
+        throw_exception(env, "Malformed key batch");
+        return 0;
+    }
+    const size_t tablebytes = (size_t) count * GET_MANY_ENTRY_BYTES;
+    if (cvalues == nullptr || count < 0 || valuesbytes < 0 || valuesbytes > env->GetDirectBufferCapacity(values) ||
+            tablebytes > (size_t) valuesbytes) {
+        throw_exception(env, "ByteBuffer is too small");
+        return 0;
+    }
+
+    const size_t keytotal = keysbytes;
+    ContextGetMany cxt = {cvalues, (size_t) valuesbytes, tablebytes, cvalues, false};
+    size_t keyoffset = 0;
+    for (jint i = 0; i < count; i++, cxt.entry += GET_MANY_ENTRY_BYTES) {
+        if (keytotal - keyoffset < sizeof(int32_t)) {
+            throw_exception(env, "Malformed key batch");
+            return 0;
+        }
+        const auto keybytes = read_int32(ckeys + keyoffset);
+        keyoffset += sizeof(int32_t);
+        if (keybytes < 0 || (size_t) keybytes > keytotal - keyoffset) {
+            throw_exception(env, "Malformed key batch");
+            return 0;
+        }
+
+        cxt.overflow = false;
+        write_int32(cxt.entry + sizeof(int32_t), 0);
+        write_int32(cxt.entry + 2 * sizeof(int32_t), 0);
+        auto status = db->get(ckeys + keyoffset, keybytes, CALLBACK_GET_MANY, &cxt);
+        write_int32(cxt.entry, cxt.overflow ? GET_MANY_STATUS_TOO_SMALL : status);
+        keyoffset += keybytes;
+    }
+    return cxt.used;
+}
+
+/*
+ * True if borrowed values of this handle wrap the engine's own memory, kept
+ * stable against concurrent writers by the engine for the duration of the
+ * callback. That is not the case with a cache, compression or shards, where
+ * the view wraps a copy or a decode buffer instead.
+ */
+extern "C" JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1borrow_1supported
+        (JNIEnv* env, jobject obj, jlong pointer) {
+    auto db = (Database*) pointer;
+    return db->borrow_stable && db->shards.size() == 1 && db->cache == nullptr && db->codec == nullptr;
+}
+
+struct ContextGetBorrowed {
+    JNIEnv* env;
+    jobject callback;
+    jmethodID mid;
+};
+
+/*
+ * The callback receives a read-only direct ByteBuffer wrapping the value:
+ * the engine's own memory, or a per-thread copy when database_borrow_supported
+ * is false for the handle. It is valid only until process() returns: its limit
+ * is reset to 0 afterwards, and neither the buffer nor any view derived from
+ * it may be used or retained past that point.
+ */
+const auto CALLBACK_GET_BORROWED = [](const char* v, size_t vb, void *arg) {
+    stats_bytes(vb);
+    const auto c = ((ContextGetBorrowed*) arg);
+    const auto env = c->env;
+    const auto buffer = env->NewDirectByteBuffer((void*) v, vb);
+    if (buffer == nullptr) return;
+    const auto view = env->CallObjectMethod(buffer, buffer_as_read_only);
+    env->DeleteLocalRef(buffer);
+    if (view == nullptr) return;
+
+    env->CallVoidMethod(c->callback, c->mid, view);
+    const auto pending = env->ExceptionOccurred();
+    if (pending != nullptr) env->ExceptionClear();
+    env->DeleteLocalRef(env->CallObjectMethod(view, buffer_limit, 0));
+    env->DeleteLocalRef(view);
+    if (pending != nullptr) {
+        env->Throw(pending);
+        env->DeleteLocalRef(pending);
+    }
+};
+
+static bool resolve_buffer_methods(JNIEnv* env) {
+    if (buffer_as_read_only != nullptr && buffer_limit != nullptr) return true;
+    const auto bytebuffer = env->FindClass("java/nio/ByteBuffer");
+    const auto buffer = env->FindClass("java/nio/Buffer");
+    if (bytebuffer == nullptr || buffer == nullptr) return false;
+    buffer_as_read_only = env->GetMethodID(bytebuffer, "asReadOnlyBuffer", "()Ljava/nio/ByteBuffer;");
+    buffer_limit = env->GetMethodID(buffer, "limit", "(I)Ljava/nio/Buffer;");
+    env->DeleteLocalRef(bytebuffer);
+    env->DeleteLocalRef(buffer);
+    return buffer_as_read_only != nullptr && buffer_limit != nullptr;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1get_1borrowed_1buffer
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jobject callback) {
+    OpTimer timer(STATS_GET_BORROWED_BUFFER);
+    auto db = (Database*) pointer;
+    const char* ckey = (char*) env->GetDirectBufferAddress(key);
+    if (!resolve_buffer_methods(env)) return false;
+    const auto mid = callback_method(env, callback, GET_BORROWED_METHOD);
+    ContextGetBorrowed cxt = {env, callback, mid};
+    auto status = db->get(ckey, keybytes, CALLBACK_GET_BORROWED, &cxt);
+    if (env->ExceptionCheck()) return false;
+    if (status != PMEMKV_STATUS_OK && status != PMEMKV_STATUS_NOT_FOUND)
+        throw_exception(env, pmemkv_errormsg());
+    return status == PMEMKV_STATUS_OK;
+}
+
+struct ContextGet {
+    JNIEnv* env;
+    jbyteArray result;
+};
+
+#define CONTEXT_GET {env, NULL}
+
+const auto CALLBACK_GET = [](const char* v, size_t vb, void *arg)  {
+    stats_bytes(vb);
+    const auto c = ((ContextGet*) arg);
+    c->result = c->env->NewByteArray(vb);
+    c->env->SetByteArrayRegion(c->result, 0, vb, (jbyte*) v);
+};
+
+extern "C" JNIEXPORT jbyteArray JNICALL Java_io_pmem_pmemkv_Database_database_1get_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key) {
+    OpTimer timer(STATS_GET_BYTES);
+    auto db = (Database*) pointer;
+    ByteArray ckey(env, key);
+    ContextGet cxt = CONTEXT_GET;
+    auto status = db->get(ckey.data(), ckey.size(), CALLBACK_GET, &cxt);
+    if (status != PMEMKV_STATUS_OK && status != PMEMKV_STATUS_NOT_FOUND)
+        throw_exception(env, pmemkv_errormsg());
+    return cxt.result;
+}
+
+#define GET_INTO_NOT_FOUND INT32_MIN
+
+struct ContextGetInto {
+    JNIEnv* env;
+    jbyteArray dest;
+    jint offset;
+    jint available;
+    jint result;
+};
+
+const auto CALLBACK_GET_INTO = [](const char* v, size_t vb, void *arg) {
+    stats_bytes(vb);
+    const auto c = ((ContextGetInto*) arg);
+    if (vb > (size_t) INT32_MAX) {
+        // its negated length would not fit in the result
+        throw_exception(c->env, "Value is too large for a Java array");
+        c->result = 0;
+    } else if (vb > (size_t) c->available) {
+        c->result = -(jint) vb;
+    } else {
+        c->env->SetByteArrayRegion(c->dest, c->offset, vb, (jbyte*) v);
+        c->result = vb;
+    }
+};
+
+/*
+ * Copies the value into 'dest' starting at 'offset' and returns its length.
+ * Returns the negated value length if it does not fit, and
+ * GET_INTO_NOT_FOUND (Integer.MIN_VALUE) if the key does not exist.
+ * Throws for values longer than Integer.MAX_VALUE.
+ */
+extern "C" JNIEXPORT jint JNICALL Java_io_pmem_pmemkv_Database_database_1get_1into_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jbyteArray dest, jint offset) {
+    OpTimer timer(STATS_GET_INTO_BYTES);
+    auto db = (Database*) pointer;
+    const auto destbytes = env->GetArrayLength(dest);
+    if (offset < 0 || offset > destbytes) {
+        throw_exception(env, "Offset out of bounds");
+        return 0;
+    }
+    ByteArray ckey(env, key);
+    ContextGetInto cxt = {env, dest, offset, destbytes - offset, GET_INTO_NOT_FOUND};
+    auto status = db->get(ckey.data(), ckey.size(), CALLBACK_GET_INTO, &cxt);
+    if (status != PMEMKV_STATUS_OK && status != PMEMKV_STATUS_NOT_FOUND)
+        throw_exception(env, pmemkv_errormsg());
+    return cxt.result;
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1put_1buffer
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jint valuebytes, jobject value) {
+    OpTimer timer(STATS_PUT_BUFFER);
+    auto db = (Database*) pointer;
+    const char* ckey = (char*) env->GetDirectBufferAddress(key);
+    const char* cvalue = (char*) env->GetDirectBufferAddress(value);
+    const auto result = db->put(ckey, keybytes, cvalue, valuebytes);
+    if (result != PMEMKV_STATUS_OK)
+        throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1put_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jbyteArray value) {
+    OpTimer timer(STATS_PUT_BYTES);
+    auto db = (Database*) pointer;
+    int result;
+    {
+        ByteArray ckey(env, key);
+        ByteArray cvalue(env, value);
+        result = db->put(ckey.data(), ckey.size(), cvalue.data(), cvalue.size());
+    }
+    if (result != PMEMKV_STATUS_OK)
+        throw_exception(env, pmemkv_errormsg());
+}
+
+#define WRITE_BATCH_PUT 1
+#define WRITE_BATCH_REMOVE 2
+#define WRITE_BATCH_MIN_RECORD_BYTES (1 + (jint) sizeof(int32_t))
+
+/*
+ * Applies 'count' operations packed into 'ops' (native byte order):
+ * [int8 WRITE_BATCH_PUT][int32 keybytes][int32 valuebytes][key][value] or
+ * [int8 WRITE_BATCH_REMOVE][int32 keybytes][key].
+ * Returns the pmemkv status of every operation, in order. Operations
+ * preceding a malformed record are applied before the exception is thrown.
+ */
+extern "C" JNIEXPORT jbyteArray JNICALL Java_io_pmem_pmemkv_Database_database_1write_1batch
+        (JNIEnv* env, jobject obj, jlong pointer, jint count, jint opsbytes, jobject ops) {
+    OpTimer timer(STATS_WRITE_BATCH);
+    auto db = (Database*) pointer;
+    const char* cops = direct_buffer(env, ops, opsbytes);
+    if (cops == nullptr) return NULL;
+    /* every record takes at least an op byte and a key length */
+    if (count < 0 || count > opsbytes / WRITE_BATCH_MIN_RECORD_BYTES) {
+        throw_exception(env, "Malformed write batch");
+        return NULL;
+    }
+
+    std::vector<jbyte> statuses(count);
+    const size_t total = opsbytes;
+    size_t offset = 0;
+    jint applied = 0;
+    for (; applied < count; applied++) {
+        if (total - offset < 1 + sizeof(int32_t)) break;
+        const auto op = cops[offset];
+        const auto keybytes = read_int32(cops + offset + 1);
+        offset += 1 + sizeof(int32_t);
+        int32_t valuebytes = 0;
+        if (op == WRITE_BATCH_PUT) {
+            if (total - offset < sizeof(int32_t)) break;
+            valuebytes = read_int32(cops + offset);
+            offset += sizeof(int32_t);
+        } else if (op != WRITE_BATCH_REMOVE) {
+            break;
+        }
+        if (keybytes < 0 || valuebytes < 0 || (size_t) keybytes + valuebytes > total - offset) break;
+
+        const char* ckey = cops + offset;
+        const char* cvalue = ckey + keybytes;
+        offset += (size_t) keybytes + valuebytes;
+        if (op == WRITE_BATCH_PUT)
+            statuses[applied] = db->put(ckey, keybytes, cvalue, valuebytes);
+        else
+            statuses[applied] = db->remove(ckey, keybytes);
+    }
+    if (applied != count) {
+        throw_exception(env, "Malformed write batch");
+        return NULL;
+    }
+
+    const auto result = env->NewByteArray(count);
+    env->SetByteArrayRegion(result, 0, count, statuses.data());
+    return result;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1remove_1buffer
+        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key) {
+    OpTimer timer(STATS_REMOVE_BUFFER);
+    auto db = (Database*) pointer;
+    const char* ckey = (char*) env->GetDirectBufferAddress(key);
+    const auto result = db->remove(ckey, keybytes);
+    if (result != PMEMKV_STATUS_OK && result != PMEMKV_STATUS_NOT_FOUND)
+        throw_exception(env, pmemkv_errormsg());
+    return result == PMEMKV_STATUS_OK;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1remove_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key) {
+    OpTimer timer(STATS_REMOVE_BYTES);
+    auto db = (Database*) pointer;
+    int result;
+    {
+        ByteArray ckey(env, key);
+        result = db->remove(ckey.data(), ckey.size());
+    }
+    if (result != PMEMKV_STATUS_OK && result != PMEMKV_STATUS_NOT_FOUND)
+        throw_exception(env, pmemkv_errormsg());
+    return result == PMEMKV_STATUS_OK;
+}
+
+/*
+ * Fixed-width long entries. Keys are stored as 8 big-endian bytes with the
+ * sign bit flipped, so byte order matches numeric order and range scans
+ * over long keys sort as numbers. Values are stored as 8 big-endian bytes,
+ * the layout of ByteBuffer.putLong, so they can also be read through the
+ * buffer and byte[] entry points.
+ */
+#define LONG_BYTES 8
+
+static inline void encode_long(char* p, uint64_t value) {
+    for (int i = LONG_BYTES - 1; i >= 0; i--, value >>= 8) p[i] = (char) (value & 0xFF);
+}
+
+static inline uint64_t decode_long(const char* p) {
+    uint64_t value = 0;
+    for (int i = 0; i < LONG_BYTES; i++) value = (value << 8) | (uint8_t) p[i];
+    return value;
+}
+
+static inline void encode_long_key(char* p, jlong key) {
+    encode_long(p, (uint64_t) key ^ (1ULL << 63));
+}
+
+struct ContextGetLong {
+    jlong value;
+    bool found;
+    bool malformed;
+};
+
+const auto CALLBACK_GET_LONG = [](const char* v, size_t vb, void *arg) {
+    const auto c = ((ContextGetLong*) arg);
+    c->found = vb == LONG_BYTES;
+    c->malformed = vb != LONG_BYTES;
+    if (c->found) c->value = (jlong) decode_long(v);
+};
+
+static int get_long(Database* db, jlong key, ContextGetLong* cxt) {
+    char ckey[LONG_BYTES];
+    encode_long_key(ckey, key);
+    return db->get(ckey, LONG_BYTES, CALLBACK_GET_LONG, cxt);
+}
+
+static int put_long(Database* db, jlong key, jlong value) {
+    char ckey[LONG_BYTES];
+    char cvalue[LONG_BYTES];
+    encode_long_key(ckey, key);
+    encode_long(cvalue, (uint64_t) value);
+    return db->put(ckey, LONG_BYTES, cvalue, LONG_BYTES);
+}
+
+static int remove_long(Database* db, jlong key) {
+    char ckey[LONG_BYTES];
+    encode_long_key(ckey, key);
+    return db->remove(ckey, LONG_BYTES);
+}
+
+/* Throws and returns true if the lookup failed or found a value that is not a long. */
+static bool get_long_failed(JNIEnv* env, int status, const ContextGetLong& cxt) {
+    if (status != PMEMKV_STATUS_OK && status != PMEMKV_STATUS_NOT_FOUND)
+        throw_exception(env, pmemkv_errormsg());
+    else if (cxt.malformed)
+        throw_exception(env, "Value is not a long");
+    else
+        return false;
+    return true;
+}
+
+/* Returns the value stored under 'key', or 'missing' if there is none. */
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1get_1long
+        (JNIEnv* env, jobject obj, jlong pointer, jlong key, jlong missing) {
+    OpTimer timer(STATS_GET_LONG);
+    ContextGetLong cxt = {missing, false, false};
+    const auto status = get_long((Database*) pointer, key, &cxt);
+    get_long_failed(env, status, cxt);
+    return cxt.value;
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1put_1long
+        (JNIEnv* env, jobject obj, jlong pointer, jlong key, jlong value) {
+    OpTimer timer(STATS_PUT_LONG);
+    if (put_long((Database*) pointer, key, value) != PMEMKV_STATUS_OK)
+        throw_exception(env, pmemkv_errormsg());
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1remove_1long
+        (JNIEnv* env, jobject obj, jlong pointer, jlong key) {
+    OpTimer timer(STATS_REMOVE_LONG);
+    const auto result = remove_long((Database*) pointer, key);
+    if (result != PMEMKV_STATUS_OK && result != PMEMKV_STATUS_NOT_FOUND)
+        throw_exception(env, pmemkv_errormsg());
+    return result == PMEMKV_STATUS_OK;
+}
+
+/*
+ * Looks up every key of 'keys' and stores its value at the same index of
+ * 'values', or 'missing' if there is none. Returns the number of keys
+ * found.
+ */
+extern "C" JNIEXPORT jint JNICALL Java_io_pmem_pmemkv_Database_database_1get_1longs
+        (JNIEnv* env, jobject obj, jlong pointer, jlongArray keys, jlongArray values, jlong missing) {
+    OpTimer timer(STATS_GET_LONGS);
+    auto db = (Database*) pointer;
+    const auto count = env->GetArrayLength(keys);
+    if (env->GetArrayLength(values) < count) {
+        throw_exception(env, "Values array is shorter than keys array");
+        return 0;
+    }
+    std::vector<jlong> ckeys(count);
+    std::vector<jlong> cvalues(count);
+    env->GetLongArrayRegion(keys, 0, count, ckeys.data());
+    jint found = 0;
+    for (jsize i = 0; i < count; i++) {
+        ContextGetLong cxt = {missing, false, false};
+        const auto status = get_long(db, ckeys[i], &cxt);
+        if (get_long_failed(env, status, cxt)) return found;
+        cvalues[i] = cxt.value;
+        found += cxt.found;
+    }
+    env->SetLongArrayRegion(values, 0, count, cvalues.data());
+    return found;
+}
+
+/* Stores values[i] under keys[i], in order. */
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1put_1longs
+        (JNIEnv* env, jobject obj, jlong pointer, jlongArray keys, jlongArray values) {
+    OpTimer timer(STATS_PUT_LONGS);
+    auto db = (Database*) pointer;
+    const auto count = env->GetArrayLength(keys);
+    if (env->GetArrayLength(values) < count) {
+        throw_exception(env, "Values array is shorter than keys array");
+        return;
+    }
+    std::vector<jlong> ckeys(count);
+    std::vector<jlong> cvalues(count);
+    env->GetLongArrayRegion(keys, 0, count, ckeys.data());
+    env->GetLongArrayRegion(values, 0, count, cvalues.data());
+    for (jsize i = 0; i < count; i++) {
+        if (put_long(db, ckeys[i], cvalues[i]) != PMEMKV_STATUS_OK) {
+            throw_exception(env, pmemkv_errormsg());
+            return;
+        }
+    }
+}
+
+/* Removes every key of 'keys'. Returns the number of keys that existed. */
+extern "C" JNIEXPORT jint JNICALL Java_io_pmem_pmemkv_Database_database_1remove_1longs
+        (JNIEnv* env, jobject obj, jlong pointer, jlongArray keys) {
+    OpTimer timer(STATS_REMOVE_LONGS);
+    auto db = (Database*) pointer;
+    const auto count = env->GetArrayLength(keys);
+    std::vector<jlong> ckeys(count);
+    env->GetLongArrayRegion(keys, 0, count, ckeys.data());
+    jint removed = 0;
+    for (jsize i = 0; i < count; i++) {
+        const auto result = remove_long(db, ckeys[i]);
+        if (result != PMEMKV_STATUS_OK && result != PMEMKV_STATUS_NOT_FOUND) {
+            throw_exception(env, pmemkv_errormsg());
+            return removed;
+        }
+        removed += result == PMEMKV_STATUS_OK;
+    }
+    return removed;
+}
+
+/*
+ * Read-modify-write operations, available when the database was opened
+ * with "jni_atomic_ops". Each holds the key's lock stripe across the read
+ * and the write, and plain writes then take the same stripe, so they are
+ * atomic without a lock on the Java side. Without the setting writes take
+ * no stripe, and these operations throw.
+ */
+
+static bool atomic_ops_enabled(JNIEnv* env, Database* db) {
+    if (db->stripes != nullptr) return true;
+    throw_exception(env, "Atomic operations are not enabled, open with jni_atomic_ops");
+    return false;
+}
+
+/*
+ * Adds 'delta' to the long value under the key, treating a missing key
+ * as 0, and leaves the sum in cxt->value. Overflow wraps around.
+ */
+static int increment(Database* db, const char* k, size_t kb, jlong delta, ContextGetLong* cxt) {
+    const auto guard = db->lock_stripe(k, kb);
+    *cxt = {0, false, false};
+    const auto status = db->get(k, kb, CALLBACK_GET_LONG, cxt);
+    if ((status != PMEMKV_STATUS_OK && status != PMEMKV_STATUS_NOT_FOUND) || cxt->malformed) return status;
+    cxt->value = (jlong) ((uint64_t) cxt->value + (uint64_t) delta);
+    char cvalue[LONG_BYTES];
+    encode_long(cvalue, (uint64_t) cxt->value);
+    return db->put_locked(k, kb, cvalue, LONG_BYTES);
+}
+
+struct ContextCompare {
+    const char* expected;
+    size_t expectedbytes;
+    bool equal;
+};
+
+const auto CALLBACK_COMPARE = [](const char* v, size_t vb, void *arg) {
+    const auto c = ((ContextCompare*) arg);
+    c->equal = vb == c->expectedbytes && std::memcmp(v, c->expected, vb) == 0;
+};
+
+/*
+ * Stores the value if the current one equals 'expected', or if the key is
+ * missing when 'expected' is null. Sets 'swapped' if it did. Returns
+ * PMEMKV_STATUS_OK or PMEMKV_STATUS_NOT_FOUND unless the engine failed.
+ */
+static int compare_and_set(Database* db, const char* k, size_t kb, const char* expected, size_t expectedbytes,
+                           const char* v, size_t vb, bool* swapped) {
+    const auto guard = db->lock_stripe(k, kb);
+    *swapped = false;
+    bool matches;
+    int status;
+    if (expected == nullptr) {
+        status = db->exists(k, kb);
+        matches = status == PMEMKV_STATUS_NOT_FOUND;
+    } else {
+        ContextCompare cxt = {expected, expectedbytes, false};
+        status = db->get(k, kb, CALLBACK_COMPARE, &cxt);
+        matches = status == PMEMKV_STATUS_OK && cxt.equal;
+    }
+    if (!matches) return status;
+    status = db->put_locked(k, kb, v, vb);
+    *swapped = status == PMEMKV_STATUS_OK;
+    return status;
+}
+
+static inline bool compare_and_set_failed(int status) {
+    return status != PMEMKV_STATUS_OK && status != PMEMKV_STATUS_NOT_FOUND;
+}
+
+/* Returns the incremented value; see increment(). */
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1increment_1long
+        (JNIEnv* env, jobject obj, jlong pointer, jlong key, jlong delta) {
+    OpTimer timer(STATS_INCREMENT);
+    if (!atomic_ops_enabled(env, (Database*) pointer)) return 0;
+    char ckey[LONG_BYTES];
+    encode_long_key(ckey, key);
+    ContextGetLong cxt;
+    const auto status = increment((Database*) pointer, ckey, LONG_BYTES, delta, &cxt);
+    get_long_failed(env, status, cxt);
+    return cxt.value;
+}
+
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1increment_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jlong delta) {
+    OpTimer timer(STATS_INCREMENT);
+    if (!atomic_ops_enabled(env, (Database*) pointer)) return 0;
+    ContextGetLong cxt;
+    int status;
+    {
+        ByteArray ckey(env, key);
+        status = increment((Database*) pointer, ckey.data(), ckey.size(), delta, &cxt);
+    }
+    get_long_failed(env, status, cxt);
+    return cxt.value;
+}
+
+/*
+ * Adds deltas[i] to the value under keys[i], in order, and returns the
+ * new values. Each key is updated atomically on its own.
+ */
+extern "C" JNIEXPORT jlongArray JNICALL Java_io_pmem_pmemkv_Database_database_1increment_1longs
+        (JNIEnv* env, jobject obj, jlong pointer, jlongArray keys, jlongArray deltas) {
+    OpTimer timer(STATS_INCREMENT);
+    auto db = (Database*) pointer;
+    if (!atomic_ops_enabled(env, db)) return NULL;
+    const auto count = env->GetArrayLength(keys);
+    if (env->GetArrayLength(deltas) < count) {
+        throw_exception(env, "Deltas array is shorter than keys array");
+        return NULL;
+    }
+    std::vector<jlong> ckeys(count);
+    std::vector<jlong> values(count);
+    env->GetLongArrayRegion(keys, 0, count, ckeys.data());
+    env->GetLongArrayRegion(deltas, 0, count, values.data());
+    for (jsize i = 0; i < count; i++) {
+        char ckey[LONG_BYTES];
+        encode_long_key(ckey, ckeys[i]);
+        ContextGetLong cxt;
+        const auto status = increment(db, ckey, LONG_BYTES, values[i], &cxt);
+        if (get_long_failed(env, status, cxt)) return NULL;
+        values[i] = cxt.value;
+    }
+    const auto result = env->NewLongArray(count);
+    if (result != NULL) env->SetLongArrayRegion(result, 0, count, values.data());
+    return result;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1compare_1and_1set_1long
+        (JNIEnv* env, jobject obj, jlong pointer, jlong key, jlong expected, jlong value) {
+    OpTimer timer(STATS_COMPARE_AND_SET);
+    if (!atomic_ops_enabled(env, (Database*) pointer)) return false;
+    char ckey[LONG_BYTES];
+    char cexpected[LONG_BYTES];
+    char cvalue[LONG_BYTES];
+    encode_long_key(ckey, key);
+    encode_long(cexpected, (uint64_t) expected);
+    encode_long(cvalue, (uint64_t) value);
+    bool swapped;
+    const auto status = compare_and_set((Database*) pointer, ckey, LONG_BYTES, cexpected, LONG_BYTES, cvalue,
+                                        LONG_BYTES, &swapped);
+    if (compare_and_set_failed(status)) throw_exception(env, pmemkv_errormsg());
+    return swapped;
+}
+
+/* A null 'expected' means the key must be missing. */
+extern "C" JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1compare_1and_1set_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jbyteArray expected, jbyteArray value) {
+    OpTimer timer(STATS_COMPARE_AND_SET);
+    auto db = (Database*) pointer;
+    if (!atomic_ops_enabled(env, db)) return false;
+    bool swapped;
+    int status;
+    {
+        ByteArray ckey(env, key);
+        ByteArray cvalue(env, value);
+        if (expected == NULL) {
+            status = compare_and_set(db, ckey.data(), ckey.size(), nullptr, 0, cvalue.data(), cvalue.size(), &swapped);
+        } else {
+            ByteArray cexpected(env, expected);
+            status = compare_and_set(db, ckey.data(), ckey.size(), cexpected.data(), cexpected.size(), cvalue.data(),
+                                     cvalue.size(), &swapped);
+        }
+    }
+    if (compare_and_set_failed(status)) throw_exception(env, pmemkv_errormsg());
+    return swapped;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1put_1if_1absent_1long
+        (JNIEnv* env, jobject obj, jlong pointer, jlong key, jlong value) {
+    OpTimer timer(STATS_PUT_IF_ABSENT);
+    if (!atomic_ops_enabled(env, (Database*) pointer)) return false;
+    char ckey[LONG_BYTES];
+    char cvalue[LONG_BYTES];
+    encode_long_key(ckey, key);
+    encode_long(cvalue, (uint64_t) value);
+    bool swapped;
+    const auto status = compare_and_set((Database*) pointer, ckey, LONG_BYTES, nullptr, 0, cvalue, LONG_BYTES,
+                                        &swapped);
+    if (compare_and_set_failed(status)) throw_exception(env, pmemkv_errormsg());
+    return swapped;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1put_1if_1absent_1bytes
+        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jbyteArray value) {
+    OpTimer timer(STATS_PUT_IF_ABSENT);
+    if (!atomic_ops_enabled(env, (Database*) pointer)) return false;
+    bool swapped;
+    int status;
+    {
+        ByteArray ckey(env, key);
+        ByteArray cvalue(env, value);
+        status = compare_and_set((Database*) pointer, ckey.data(), ckey.size(), nullptr, 0, cvalue.data(),
+                                 cvalue.size(), &swapped);
+    }
+    if (compare_and_set_failed(status)) throw_exception(env, pmemkv_errormsg());
+    return swapped;
+}
+
+/*
+ * Snapshot files hold a sorted run of records for backups and bulk
+ * rebuilds. All integers are little-endian:
+ *
+ *   header: "PMKVSNP1" [uint32 version][uint32 block bytes]
+ *   block:  [uint32 payload bytes][uint32 records][uint32 CRC32C of payload]
+ *           payload: [uint32 keybytes][uint32 valuebytes][key][value]...
+ *   end:    a block with no records whose payload is [uint64 total records]
+ *
+ * Blocks are written whole, so the file is produced and consumed with
+ * large sequential I/O. An export goes to "<path>.tmp" and is renamed into
+ * place once complete. Progress, in records, is readable while either
+ * runs through database_snapshot_progress.
+ */
+#define SNAPSHOT_MAGIC "PMKVSNP1"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_BLOCK_BYTES (1 << 20)
+#define SNAPSHOT_BLOCK_HEADER_BYTES 12
+
+struct Crc32cTable {
+    uint32_t entries[256];
+
+    Crc32cTable() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0x82F63B78 & (0 - (crc & 1)));
+            entries[i] = crc;
+        }
+    }
+};
+
+static uint32_t crc32c(const char* data, size_t bytes) {
+    uint32_t crc = ~0U;
+#ifdef __SSE4_2__
+    for (; bytes >= sizeof(uint64_t); bytes -= sizeof(uint64_t), data += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        crc = (uint32_t) _mm_crc32_u64(crc, word);
+    }
+    for (; bytes > 0; bytes--, data++) crc = _mm_crc32_u8(crc, (uint8_t) *data);
+#else
+    static const Crc32cTable table;
+    for (; bytes > 0; bytes--, data++) crc = table.entries[(crc ^ (uint8_t) *data) & 0xFF] ^ (crc >> 8);
+#endif
+    return ~crc;
 }
 
-const auto CALLBACK_GET_ALL_STRING = [](const char* k, size_t kb, const char* v, size_t vb, void *arg) -> int {
-    const auto c = ((Context*) arg);
-    const auto ckey = c->env->NewStringUTF(k);
-    const auto cvalue = c->env->NewStringUTF(v);
-    c->env->CallVoidMethod(c->callback, c->mid, ckey, cvalue);
-    c->env->DeleteLocalRef(ckey);
-    c->env->DeleteLocalRef(cvalue);
+struct SnapshotWriter {
+    FILE* file;
+    std::vector<char> block;
+    uint32_t records;
+    uint64_t total;
+    std::atomic<uint64_t>* progress;
+    bool failed;
+
+    bool flush(uint32_t count) {
+        char header[SNAPSHOT_BLOCK_HEADER_BYTES];
+        store_le32(header, block.size());
+        store_le32(header + 4, count);
+        store_le32(header + 8, crc32c(block.data(), block.size()));
+        failed = failed || fwrite(header, sizeof(header), 1, file) != 1 ||
+                (!block.empty() && fwrite(block.data(), block.size(), 1, file) != 1);
+        block.clear();
+        records = 0;
+        return !failed;
+    }
+};
+
+const auto CALLBACK_SNAPSHOT_EXPORT = [](const char* k, size_t kb, const char* v, size_t vb, void *arg) -> int {
+    stats_bytes(kb + vb);
+    const auto w = ((SnapshotWriter*) arg);
+    if (w->records > 0 && w->block.size() + 8 + kb + vb > SNAPSHOT_BLOCK_BYTES && !w->flush(w->records)) return 1;
+    char lengths[8];
+    store_le32(lengths, kb);
+    store_le32(lengths + 4, vb);
+    w->block.insert(w->block.end(), lengths, lengths + sizeof(lengths));
+    w->block.insert(w->block.end(), k, k + kb);
+    w->block.insert(w->block.end(), v, v + vb);
+    w->records++;
+    w->total++;
+    w->progress->store(w->total, std::memory_order_relaxed);
     return 0;
 };
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1string
-        (JNIEnv* env, jobject obj, jlong pointer, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_ALL_STRING);
-    Context cxt = CONTEXT;
-    auto status = pmemkv_get_all(engine, CALLBACK_GET_ALL_STRING, &cxt);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
+/*
+ * Writes the records from 'start' (inclusive, null for the first key) to
+ * 'end' (exclusive, null for no bound) to a snapshot file and returns how
+ * many were written.
+ */
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1export_1snapshot
+        (JNIEnv* env, jobject obj, jlong pointer, jstring path, jbyteArray start, jbyteArray end) {
+    OpTimer timer(STATS_SNAPSHOT_EXPORT);
+    auto db = (Database*) pointer;
+    const char* cpath = env->GetStringUTFChars(path, NULL);
+    if (cpath == NULL) return 0;
+    const std::string target = cpath;
+    const std::string temporary = target + ".tmp";
+    env->ReleaseStringUTFChars(path, cpath);
+
+    std::string lower, upper;
+    if (start != NULL) {
+        ByteArray cstart(env, start);
+        lower.assign(cstart.data(), cstart.size());
+    }
+    if (end != NULL) {
+        ByteArray cend(env, end);
+        upper.assign(cend.data(), cend.size());
+    }
+
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (file == nullptr) {
+        throw_exception(env, "Cannot create snapshot file");
+        return 0;
+    }
+    SnapshotWriter w = {file, {}, 0, 0, &db->snapshot_progress, false};
+    w.block.reserve(SNAPSHOT_BLOCK_BYTES);
+    db->snapshot_progress = 0;
+
+    char header[sizeof(SNAPSHOT_MAGIC) - 1 + 8];
+    std::memcpy(header, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC) - 1);
+    store_le32(header + 8, SNAPSHOT_VERSION);
+    store_le32(header + 12, SNAPSHOT_BLOCK_BYTES);
+    w.failed = fwrite(header, sizeof(header), 1, file) != 1;
+
+    int status = PMEMKV_STATUS_OK;
+    if (start != NULL && !w.failed) {
+        ContextPrefixExact exact = {CALLBACK_SNAPSHOT_EXPORT, &w, lower.data(), lower.size(), 0};
+        status = kv_get(db, lower.data(), lower.size(), CALLBACK_PREFIX_EXACT, &exact);
+        if (status == PMEMKV_STATUS_NOT_FOUND) status = PMEMKV_STATUS_OK;
+    }
+    if (status == PMEMKV_STATUS_OK && !w.failed) {
+        if (start != NULL && end != NULL)
+            status = timed(kv_get_between, db, lower.data(), lower.size(), upper.data(), upper.size(), CALLBACK_SNAPSHOT_EXPORT, &w);
+        else if (start != NULL)
+            status = timed(kv_get_above, db, lower.data(), lower.size(), CALLBACK_SNAPSHOT_EXPORT, &w);
+        else if (end != NULL)
+            status = timed(kv_get_below, db, upper.data(), upper.size(), CALLBACK_SNAPSHOT_EXPORT, &w);
+        else
+            status = timed(kv_get_all, db, CALLBACK_SNAPSHOT_EXPORT, &w);
+    }
+    if (status == PMEMKV_STATUS_OK && !w.failed && w.records > 0) w.flush(w.records);
+    if (status == PMEMKV_STATUS_OK && !w.failed) {
+        char trailer[8];
+        store_le32(trailer, (uint32_t) w.total);
+        store_le32(trailer + 4, (uint32_t) (w.total >> 32));
+        w.block.assign(trailer, trailer + sizeof(trailer));
+        w.flush(0);
+    }
+    const bool closed = fclose(file) == 0;
+
+    if (status != PMEMKV_STATUS_OK || w.failed || !closed || std::rename(temporary.c_str(), target.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        throw_exception(env, w.failed || !scan_failed(status) ? "Cannot write snapshot file" : pmemkv_errormsg());
+        return 0;
+    }
+    return w.total;
 }
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1string
-        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto ckey = env->GetByteArrayElements(key, NULL);
-    const auto ckeybytes = env->GetArrayLength(key);
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_ALL_STRING);
-    Context cxt = CONTEXT;
-    auto status = pmemkv_get_above(engine, (char*) ckey, ckeybytes, CALLBACK_GET_ALL_STRING, &cxt);
-    env->ReleaseByteArrayElements(key, ckey, JNI_ABORT);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
+/*
+ * Puts every record of a snapshot file, verifying each block's checksum
+ * before applying it, and returns how many were imported. Blocks before a
+ * corrupted one have already been applied when the exception is thrown.
+ * Block headers are not covered by the checksum, so a payload length is
+ * only trusted if it fits in the rest of the file and in the declared
+ * block size; a block can only be larger when it holds a single record.
+ */
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1import_1snapshot
+        (JNIEnv* env, jobject obj, jlong pointer, jstring path) {
+    OpTimer timer(STATS_SNAPSHOT_IMPORT);
+    auto db = (Database*) pointer;
+    const char* cpath = env->GetStringUTFChars(path, NULL);
+    if (cpath == NULL) return 0;
+    FILE* file = fopen(cpath, "rb");
+    env->ReleaseStringUTFChars(path, cpath);
+    if (file == nullptr) {
+        throw_exception(env, "Cannot open snapshot file");
+        return 0;
+    }
+    std::unique_ptr<FILE, int (*)(FILE*)> closer(file, fclose);
+    db->snapshot_progress = 0;
+
+    long length = -1;
+    if (fseek(file, 0, SEEK_END) == 0) length = ftell(file);
+    char header[sizeof(SNAPSHOT_MAGIC) - 1 + 8];
+    if (length < 0 || fseek(file, 0, SEEK_SET) != 0 || fread(header, sizeof(header), 1, file) != 1 ||
+            std::memcmp(header, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC) - 1) != 0 ||
+            load_le32(header + 8) != SNAPSHOT_VERSION) {
+        throw_exception(env, "Not a snapshot file");
+        return 0;
+    }
+    const uint32_t blockbytes = load_le32(header + 12);
+
+    std::vector<char> block;
+    uint64_t total = 0;
+    while (true) {
+        char blockheader[SNAPSHOT_BLOCK_HEADER_BYTES];
+        if (fread(blockheader, sizeof(blockheader), 1, file) != 1) break;
+        const uint32_t payloadbytes = load_le32(blockheader);
+        const uint32_t records = load_le32(blockheader + 4);
+        const long position = ftell(file);
+        if (position < 0 || payloadbytes > (uint64_t) (length - position) ||
+                (payloadbytes > blockbytes && records != 1))
+            break;
+        try {
+            block.resize(payloadbytes);
+        } catch (const std::bad_alloc&) {
+            throw_exception(env, "Cannot allocate snapshot block");
+            return total;
+        }
+        if ((payloadbytes > 0 && fread(block.data(), payloadbytes, 1, file) != 1) ||
+                crc32c(block.data(), payloadbytes) != load_le32(blockheader + 8))
+            break;
+
+        if (records == 0) {
+            if (payloadbytes != 8) break;
+            const uint64_t expected = load_le32(block.data()) | ((uint64_t) load_le32(block.data() + 4) << 32);
+            if (expected != total) break;
+            return total;
+        }
+
+        size_t offset = 0;
+        uint32_t applied = 0;
+        for (; applied < records && payloadbytes - offset >= 8; applied++) {
+            const uint32_t keybytes = load_le32(block.data() + offset);
+            const uint32_t valuebytes = load_le32(block.data() + offset + 4);
+            offset += 8;
+            if ((uint64_t) keybytes + valuebytes > payloadbytes - offset) break;
+            const char* key = block.data() + offset;
+            const auto status = db->put(key, keybytes, key + keybytes, valuebytes);
+            if (status != PMEMKV_STATUS_OK) {
+                throw_exception(env, pmemkv_errormsg());
+                return total;
+            }
+            offset += (size_t) keybytes + valuebytes;
+            db->snapshot_progress.store(++total, std::memory_order_relaxed);
+        }
+        if (applied != records || offset != payloadbytes) break;
+    }
+    throw_exception(env, "Corrupted snapshot file");
+    return total;
 }
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1string
-        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto ckey = env->GetByteArrayElements(key, NULL);
-    const auto ckeybytes = env->GetArrayLength(key);
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_ALL_STRING);
-    Context cxt = CONTEXT;
-    auto status = pmemkv_get_below(engine, (char*) ckey, ckeybytes, CALLBACK_GET_ALL_STRING, &cxt);
-    env->ReleaseByteArrayElements(key, ckey, JNI_ABORT);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1snapshot_1progress
+        (JNIEnv* env, jobject obj, jlong pointer) {
+    return ((Database*) pointer)->snapshot_progress.load(std::memory_order_relaxed);
 }
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1string
-        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key1, jbyteArray key2, jobject callback) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto ckey1 = env->GetByteArrayElements(key1, NULL);
-    const auto ckeybytes1 = env->GetArrayLength(key1);
-    const auto ckey2 = env->GetByteArrayElements(key2, NULL);
-    const auto ckeybytes2 = env->GetArrayLength(key2);
-    const auto cls = env->GetObjectClass(callback);
-    const auto mid = env->GetMethodID(cls, "process", METHOD_GET_ALL_STRING);
-    Context cxt = CONTEXT;
-    auto status = pmemkv_get_between(engine, (char*) ckey1, ckeybytes1, (char*) ckey2, ckeybytes2, CALLBACK_GET_ALL_STRING, &cxt);
-    env->ReleaseByteArrayElements(key1, ckey1, JNI_ABORT);
-    env->ReleaseByteArrayElements(key2, ckey2, JNI_ABORT);
-    if (status != PMEMKV_STATUS_OK) env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
+#define BULK_LOAD_STATS 5
+
+/*
+ * Bulk load session for pre-sorted input. Chunks of records packed as
+ * [int32 keybytes][int32 valuebytes][key][value] (native byte order) are
+ * copied into a pending slot and applied by a loader thread, so Java can
+ * fill the next chunk while the previous one is written. Keys must be
+ * strictly increasing across the whole session; records that are not are
+ * skipped and counted as rejected. After a failed put the remaining chunks
+ * are dropped and the error is thrown by the next call.
+ */
+struct BulkLoad {
+    Database* db;
+    std::mutex lock;
+    std::condition_variable cond;
+    std::vector<char> pending;
+    bool has_pending = false;
+    bool finishing = false;
+    bool failed = false;
+    std::string error;
+    std::string last_key;
+    bool has_last = false;
+    std::atomic<uint64_t> records{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> rejected{0};
+    std::atomic<uint64_t> chunks{0};
+    const std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    std::thread loader;
+
+    explicit BulkLoad(Database* db) : db(db), loader([this] { run(); }) {}
+
+    void run() {
+        std::vector<char> chunk;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                cond.wait(guard, [this] { return has_pending || finishing; });
+                if (!has_pending) return;
+                chunk.swap(pending);
+                has_pending = false;
+            }
+            cond.notify_all();
+            if (!failed) apply(chunk);
+        }
+    }
+
+    void apply(const std::vector<char>& chunk) {
+        OpTimer timer(STATS_BULK_LOAD);
+        stats_bytes(chunk.size());
+        const char* p = chunk.data();
+        size_t offset = 0;
+        while (offset < chunk.size()) {
+            const auto keybytes = read_int32(p + offset);
+            const auto valuebytes = read_int32(p + offset + sizeof(int32_t));
+            const char* key = p + offset + 2 * sizeof(int32_t);
+            offset += 2 * sizeof(int32_t) + keybytes + valuebytes;
+            if (has_last && compare_keys(key, keybytes, last_key.data(), last_key.size()) <= 0) {
+                rejected.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            if (db->put(key, keybytes, key + keybytes, valuebytes) != PMEMKV_STATUS_OK) {
+                std::lock_guard<std::mutex> guard(lock);
+                error = pmemkv_errormsg();
+                failed = true;
+                return;
+            }
+            last_key.assign(key, keybytes);
+            has_last = true;
+            records.fetch_add(1, std::memory_order_relaxed);
+            bytes.fetch_add((uint64_t) keybytes + valuebytes, std::memory_order_relaxed);
+        }
+        chunks.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Returns false if a previous chunk failed.
+    bool submit(const char* chunk, size_t chunkbytes) {
+        std::unique_lock<std::mutex> guard(lock);
+        cond.wait(guard, [this] { return !has_pending || failed; });
+        if (failed) return false;
+        pending.assign(chunk, chunk + chunkbytes);
+        has_pending = true;
+        guard.unlock();
+        cond.notify_all();
+        return true;
+    }
+
+    void finish() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            finishing = true;
+        }
+        cond.notify_all();
+        loader.join();
+    }
+
+    jlongArray stats(JNIEnv* env) {
+        const jlong values[BULK_LOAD_STATS] = {
+            (jlong) records.load(std::memory_order_relaxed),
+            (jlong) bytes.load(std::memory_order_relaxed),
+            (jlong) rejected.load(std::memory_order_relaxed),
+            (jlong) chunks.load(std::memory_order_relaxed),
+            (jlong) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - started).count()
+        };
+        const auto result = env->NewLongArray(BULK_LOAD_STATS);
+        if (result != NULL) env->SetLongArrayRegion(result, 0, BULK_LOAD_STATS, values);
+        return result;
+    }
+};
+
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1bulk_1load_1begin
+        (JNIEnv* env, jobject obj, jlong pointer) {
+    return (jlong) new BulkLoad((Database*) pointer);
 }
 
-extern "C" JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1exists_1buffer
-        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key) {
-    auto engine = (pmemkv_db*) pointer;
-    const char* ckey = (char*) env->GetDirectBufferAddress(key);
-    auto status = pmemkv_exists(engine, ckey, keybytes);
-    if (status != PMEMKV_STATUS_OK && status != PMEMKV_STATUS_NOT_FOUND)
-        env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
-    return status == PMEMKV_STATUS_OK;
+/*
+ * Queues one chunk, waiting while the previous chunk is still pending.
+ * The chunk is checked for framing before it is copied, so a malformed
+ * chunk is rejected as a whole.
+ */
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1bulk_1load_1chunk
+        (JNIEnv* env, jobject obj, jlong pointer, jint chunkbytes, jobject chunk) {
+    auto session = (BulkLoad*) pointer;
+    const char* cchunk = direct_buffer(env, chunk, chunkbytes);
+    if (cchunk == nullptr) return;
+    const size_t total = chunkbytes;
+    size_t offset = 0;
+    while (total - offset >= 2 * sizeof(int32_t)) {
+        const auto keybytes = read_int32(cchunk + offset);
+        const auto valuebytes = read_int32(cchunk + offset + sizeof(int32_t));
+        const size_t header = 2 * sizeof(int32_t);
+        if (keybytes < 0 || valuebytes < 0 || (size_t) keybytes + valuebytes > total - offset - header) break;
+        offset += header + keybytes + valuebytes;
+    }
+    if (offset != total) {
+        throw_exception(env, "Malformed bulk load chunk");
+        return;
+    }
+    if (total > 0 && !session->submit(cchunk, total))
+        throw_exception(env, session->error.c_str());
+}
+
+/*
+ * Returns {records, bytes, rejected, chunks, elapsed nanoseconds} for the
+ * records applied so far.
+ */
+extern "C" JNIEXPORT jlongArray JNICALL Java_io_pmem_pmemkv_Database_database_1bulk_1load_1stats
+        (JNIEnv* env, jobject obj, jlong pointer) {
+    return ((BulkLoad*) pointer)->stats(env);
+}
 
+/*
+ * Waits for the queued chunks to be applied, frees the session and
+ * returns its final stats, or throws if a put failed.
+ */
+extern "C" JNIEXPORT jlongArray JNICALL Java_io_pmem_pmemkv_Database_database_1bulk_1load_1finish
+        (JNIEnv* env, jobject obj, jlong pointer) {
+    auto session = (BulkLoad*) pointer;
+    session->finish();
+    jlongArray result = NULL;
+    if (session->failed)
+        throw_exception(env, session->error.c_str());
+    else
+        result = session->stats(env);
+    delete session;
+    return result;
 }
 
-extern "C" JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1exists_1bytes
-        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto ckey = env->GetByteArrayElements(key, NULL);
-    const auto ckeybytes = env->GetArrayLength(key);
-    const auto result = pmemkv_exists(engine, (char*) ckey, ckeybytes) == PMEMKV_STATUS_OK;
-    env->ReleaseByteArrayElements(key, ckey, JNI_ABORT);
+#define CACHE_STATS 5
+
+/*
+ * Returns {hits, misses, evictions, entries, bytes} of the read cache, or
+ * zeros if the database was started without one.
+ */
+extern "C" JNIEXPORT jlongArray JNICALL Java_io_pmem_pmemkv_Database_database_1cache_1stats
+        (JNIEnv* env, jobject obj, jlong pointer) {
+    auto db = (Database*) pointer;
+    jlong stats[CACHE_STATS] = {};
+    if (db->cache != nullptr) db->cache->stats(stats);
+    const auto result = env->NewLongArray(CACHE_STATS);
+    env->SetLongArrayRegion(result, 0, CACHE_STATS, stats);
     return result;
 }
 
-struct ContextGetBuffer {
-    JNIEnv* env;
-    int valuebytes;
+/*
+ * Returns {compressed values, raw values, value bytes in, bytes stored,
+ * compression ns, decompressed values, decompression ns} of the value
+ * codec, or zeros if compression is off. Values stored raw still count
+ * their header byte in bytes stored.
+ */
+extern "C" JNIEXPORT jlongArray JNICALL Java_io_pmem_pmemkv_Database_database_1codec_1stats
+        (JNIEnv* env, jobject obj, jlong pointer) {
+    auto db = (Database*) pointer;
+    jlong stats[CODEC_STATS] = {};
+    if (db->codec != nullptr) db->codec->stats(stats);
+    const auto result = env->NewLongArray(CODEC_STATS);
+    env->SetLongArrayRegion(result, 0, CODEC_STATS, stats);
+    return result;
+}
+
+#define BLOOM_STATS 5
+
+/*
+ * Returns {skipped, passed, false positives, bits set, filter bits} of
+ * the Bloom filter since it was last built, or zeros if it is disabled.
+ * Skipped lookups were answered without touching the engine.
+ */
+extern "C" JNIEXPORT jlongArray JNICALL Java_io_pmem_pmemkv_Database_database_1bloom_1stats
+        (JNIEnv* env, jobject obj, jlong pointer) {
+    auto db = (Database*) pointer;
+    jlong stats[BLOOM_STATS] = {};
+    const auto filter = db->bloom.load();
+    if (filter != nullptr) {
+        stats[0] = db->bloom_skipped;
+        stats[1] = db->bloom_passed;
+        stats[2] = db->bloom_false;
+        stats[3] = filter->bits_set();
+        stats[4] = filter->bits();
+    }
+    const auto result = env->NewLongArray(BLOOM_STATS);
+    env->SetLongArrayRegion(result, 0, BLOOM_STATS, stats);
+    return result;
+}
+
+/*
+ * Observed false positive rate over lookups of absent keys, or the rate
+ * expected from the filter's fill while no absent key has been looked up.
+ */
+extern "C" JNIEXPORT jdouble JNICALL Java_io_pmem_pmemkv_Database_database_1bloom_1false_1positive_1rate
+        (JNIEnv* env, jobject obj, jlong pointer) {
+    auto db = (Database*) pointer;
+    const auto filter = db->bloom.load();
+    if (filter == nullptr) return 0;
+    const uint64_t negatives = db->bloom_skipped + db->bloom_false;
+    if (negatives == 0) return filter->estimated_rate();
+    return (double) db->bloom_false / negatives;
+}
+
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1bloom_1rebuild
+        (JNIEnv* env, jobject obj, jlong pointer) {
+    auto db = (Database*) pointer;
+    if (db->rebuild_bloom() != PMEMKV_STATUS_OK) throw_exception(env, pmemkv_errormsg());
+}
+
+#define STATS_FIELDS 10
+
+static uint64_t stats_percentile(const uint64_t* buckets, uint64_t count, double fraction) {
+    if (count == 0) return 0;
+    const uint64_t rank = std::max((uint64_t) 1, (uint64_t) (fraction * count + 0.999999));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < STATS_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= rank) return stats_bucket_value(i);
+    }
+    return stats_bucket_value(STATS_BUCKETS - 1);
+}
+
+/*
+ * Names of the operations reported by database_stats, in the same order.
+ */
+extern "C" JNIEXPORT jobjectArray JNICALL Java_io_pmem_pmemkv_Database_database_1stats_1names
+        (JNIEnv* env, jobject obj) {
+    const auto string_class = env->FindClass("java/lang/String");
+    const auto result = env->NewObjectArray(STATS_OP_COUNT, string_class, nullptr);
+    for (int i = 0; i < STATS_OP_COUNT && result != nullptr; i++) {
+        const auto name = env->NewStringUTF(STATS_OP_NAMES[i]);
+        env->SetObjectArrayElement(result, i, name);
+        env->DeleteLocalRef(name);
+    }
+    env->DeleteLocalRef(string_class);
+    return result;
+}
+
+/*
+ * Merges the counters of all threads. For each operation the snapshot holds
+ * {count, bytes, total p50, p99, p999, max, engine p50, p99, p999, max},
+ * latencies in nanoseconds.
+ */
+extern "C" JNIEXPORT jlongArray JNICALL Java_io_pmem_pmemkv_Database_database_1stats
+        (JNIEnv* env, jobject obj) {
+    std::vector<jlong> snapshot(STATS_OP_COUNT * STATS_FIELDS);
+    std::vector<uint64_t> total(STATS_BUCKETS), engine(STATS_BUCKETS);
+    std::lock_guard<std::mutex> guard(stats_lock);
+    for (int op = 0; op < STATS_OP_COUNT; op++) {
+        uint64_t count = 0, bytes = 0;
+        std::fill(total.begin(), total.end(), 0);
+        std::fill(engine.begin(), engine.end(), 0);
+        for (const auto block : stats_blocks) {
+            const auto& s = block->ops[op];
+            count += s.count.load(std::memory_order_relaxed);
+            bytes += s.bytes.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < STATS_BUCKETS; i++) {
+                total[i] += s.total[i].load(std::memory_order_relaxed);
+                engine[i] += s.engine[i].load(std::memory_order_relaxed);
+            }
+        }
+        // buckets may be a little ahead of count, use their own sum
+        uint64_t recorded = 0;
+        for (size_t i = 0; i < STATS_BUCKETS; i++) recorded += total[i];
+        const auto fields = &snapshot[op * STATS_FIELDS];
+        fields[0] = count;
+        fields[1] = bytes;
+        fields[2] = stats_percentile(total.data(), recorded, 0.5);
+        fields[3] = stats_percentile(total.data(), recorded, 0.99);
+        fields[4] = stats_percentile(total.data(), recorded, 0.999);
+        fields[5] = stats_percentile(total.data(), recorded, 1);
+        fields[6] = stats_percentile(engine.data(), recorded, 0.5);
+        fields[7] = stats_percentile(engine.data(), recorded, 0.99);
+        fields[8] = stats_percentile(engine.data(), recorded, 0.999);
+        fields[9] = stats_percentile(engine.data(), recorded, 1);
+    }
+    const auto result = env->NewLongArray(snapshot.size());
+    env->SetLongArrayRegion(result, 0, snapshot.size(), snapshot.data());
+    return result;
+}
+
+#define ASYNC_GET_BUFFER 1
+#define ASYNC_PUT_BUFFER 2
+#define ASYNC_REMOVE_BUFFER 3
+#define ASYNC_GET_ALL_BATCH 4
+
+/*
+ * Asynchronous operations are executed by a pool of native threads attached
+ * to the JVM as daemons, and complete a java.util.concurrent.CompletableFuture:
+ * get with the value length (null if not found), put with null, remove with
+ * whether the key existed and a batched scan with null once the last batch
+ * was delivered. Workers take up to 'batch' queued operations at a time, run
+ * them and then complete their futures together. Buffers are checked when
+ * the operation is submitted, and must not be touched, nor the database
+ * stopped, until its future completes.
+ *
+ * Futures are completed on the worker, so dependent stages that are not
+ * async run there too. Such a stage must not delete the pool, which would
+ * have the worker wait for itself; database_async_pool_delete throws when
+ * called from one of the pool's own workers.
+ */
+struct AsyncMethods {
+    jclass integer_class;
+    jmethodID integer_value_of;
+    jclass boolean_class;
+    jmethodID boolean_value_of;
+    jmethodID future_complete;
+    jmethodID future_complete_exceptionally;
+    jmethodID exception_init;
+};
+
+static AsyncMethods async_methods = {};
+static std::mutex async_methods_lock;
+
+static bool resolve_async_methods(JNIEnv* env) {
+    std::lock_guard<std::mutex> guard(async_methods_lock);
+    if (async_methods.exception_init != nullptr) return true;
+    AsyncMethods m = {};
+    m.integer_class = global_class(env, "java/lang/Integer");
+    m.boolean_class = global_class(env, "java/lang/Boolean");
+    const auto future = env->FindClass("java/util/concurrent/CompletableFuture");
+    if (m.integer_class != nullptr && m.boolean_class != nullptr && future != nullptr && exception_class != nullptr) {
+        m.integer_value_of = env->GetStaticMethodID(m.integer_class, "valueOf", "(I)Ljava/lang/Integer;");
+        m.boolean_value_of = env->GetStaticMethodID(m.boolean_class, "valueOf", "(Z)Ljava/lang/Boolean;");
+        m.future_complete = env->GetMethodID(future, "complete", "(Ljava/lang/Object;)Z");
+        m.future_complete_exceptionally = env->GetMethodID(future, "completeExceptionally", "(Ljava/lang/Throwable;)Z");
+        m.exception_init = env->GetMethodID(exception_class, "<init>", "(Ljava/lang/String;)V");
+    }
+    if (future != nullptr) env->DeleteLocalRef(future);
+    if (m.exception_init == nullptr || env->ExceptionCheck()) {
+        for (auto cls : {m.integer_class, m.boolean_class})
+            if (cls != nullptr) env->DeleteGlobalRef(cls);
+        return false;
+    }
+    async_methods = m;
+    return true;
+}
+
+struct AsyncOp {
+    int type;
+    Database* db;
+    jobject future;
+    jobject key;
+    const char* ckey;
+    jint keybytes;
     jobject value;
+    char* cvalue;
+    jint valuebytes;
+    jobject callback;
+    jmethodID mid;
+    int status;
     jint result;
+    std::string error;
+    jthrowable thrown;
 };
 
-#define CONTEXT_GET_BUFFER {env, valuebytes, value, 0}
+struct ContextAsyncGet {
+    char* value;
+    size_t valuebytes;
+    size_t result;
+};
 
-const auto CALLBACK_GET_BUFFER = [](const char* v, size_t vb, void *arg) {
-    const auto c = ((ContextGetBuffer*) arg);
-    if (vb > c->valuebytes) {
-        c->env->ThrowNew(c->env->FindClass(EXCEPTION_CLASS), "ByteBuffer is too small");
-    } else {
-        char* cvalue = (char*) c->env->GetDirectBufferAddress(c->value);
-        std::memcpy(cvalue, v, vb);
-        c->result = vb;
+const auto CALLBACK_ASYNC_GET = [](const char* v, size_t vb, void *arg) {
+    stats_bytes(vb);
+    const auto c = ((ContextAsyncGet*) arg);
+    c->result = vb;
+    if (vb <= c->valuebytes) std::memcpy(c->value, v, vb);
+};
+
+class AsyncPool;
+
+static thread_local const AsyncPool* current_async_pool = nullptr;
+
+class AsyncPool {
+public:
+    AsyncPool(JavaVM* vm, size_t threads, size_t batch) : vm(vm), batch(batch) {
+        for (size_t i = 0; i < threads; i++)
+            workers.emplace_back(&AsyncPool::run, this);
     }
+
+    ~AsyncPool() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        ready.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    bool submit(AsyncOp* op) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (stopping) return false;
+            queue.push_back(op);
+        }
+        ready.notify_one();
+        return true;
+    }
+
+private:
+    void run() {
+        JNIEnv* env;
+        JavaVMAttachArgs args = {JNI_VERSION_1_6, (char*) "pmemkv-async", NULL};
+        if (vm->AttachCurrentThreadAsDaemon((void**) &env, &args) != JNI_OK) return;
+        current_async_pool = this;
+
+        std::vector<AsyncOp*> ops;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                ready.wait(guard, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) break;
+                while (!queue.empty() && ops.size() < batch) {
+                    ops.push_back(queue.front());
+                    queue.pop_front();
+                }
+            }
+            for (auto op : ops) execute(env, op);
+            for (auto op : ops) complete(env, op);
+            ops.clear();
+        }
+        vm->DetachCurrentThread();
+    }
+
+    static void execute(JNIEnv* env, AsyncOp* op) {
+        static const int ASYNC_STATS[] = {0, STATS_ASYNC_GET, STATS_ASYNC_PUT, STATS_ASYNC_REMOVE, STATS_ASYNC_SCAN};
+        OpTimer timer(ASYNC_STATS[op->type]);
+        const auto ckey = op->ckey;
+        const auto cvalue = op->cvalue;
+        switch (op->type) {
+            case ASYNC_GET_BUFFER: {
+                ContextAsyncGet cxt = {cvalue, (size_t) op->valuebytes, 0};
+                op->status = op->db->get(ckey, op->keybytes, CALLBACK_ASYNC_GET, &cxt);
+                op->result = cxt.result;
+                if (op->status == PMEMKV_STATUS_OK && cxt.result > cxt.valuebytes) {
+                    op->status = PMEMKV_STATUS_INVALID_ARGUMENT;
+                    op->error = "ByteBuffer is too small";
+                    return;
+                }
+                break;
+            }
+            case ASYNC_PUT_BUFFER:
+                op->status = op->db->put(ckey, op->keybytes, cvalue, op->valuebytes);
+                break;
+            case ASYNC_REMOVE_BUFFER:
+                op->status = op->db->remove(ckey, op->keybytes);
+                break;
+            case ASYNC_GET_ALL_BATCH: {
+                const auto callback = op->callback;
+                const auto mid = op->mid;
+                const auto cbatch = cvalue;
+                const auto batchbytes = op->valuebytes;
+                const jlong limit = 0;
+                ContextGetAllBatch cxt = CONTEXT_GET_ALL_BATCH;
+                op->status = timed(kv_get_all, op->db, CALLBACK_GET_ALL_BATCH, &cxt);
+                if (!env->ExceptionCheck() && op->status == PMEMKV_STATUS_OK) flush_batch(&cxt);
+                if (env->ExceptionCheck()) {
+                    op->thrown = (jthrowable) env->NewGlobalRef(env->ExceptionOccurred());
+                    env->ExceptionClear();
+                    return;
+                }
+                break;
+            }
+        }
+        if (op->status != PMEMKV_STATUS_OK && op->status != PMEMKV_STATUS_NOT_FOUND)
+            op->error = pmemkv_errormsg();
+    }
+
+    static void complete(JNIEnv* env, AsyncOp* op) {
+        const auto& m = async_methods;
+        if (op->thrown != nullptr || !op->error.empty()) {
+            jobject exception = op->thrown;
+            if (exception == nullptr) {
+                const auto message = env->NewStringUTF(op->error.c_str());
+                exception = env->NewObject(exception_class, m.exception_init, message);
+                env->DeleteLocalRef(message);
+            }
+            env->CallBooleanMethod(op->future, m.future_complete_exceptionally, exception);
+            if (op->thrown == nullptr) env->DeleteLocalRef(exception);
+        } else {
+            jobject result = nullptr;
+            if (op->type == ASYNC_GET_BUFFER && op->status == PMEMKV_STATUS_OK)
+                result = env->CallStaticObjectMethod(m.integer_class, m.integer_value_of, op->result);
+            else if (op->type == ASYNC_REMOVE_BUFFER)
+                result = env->CallStaticObjectMethod(m.boolean_class, m.boolean_value_of, (jboolean) (op->status == PMEMKV_STATUS_OK));
+            env->CallBooleanMethod(op->future, m.future_complete, result);
+            if (result != nullptr) env->DeleteLocalRef(result);
+        }
+        if (env->ExceptionCheck()) env->ExceptionClear();
+
+        for (auto ref : {op->future, op->key, op->value, op->callback, (jobject) op->thrown})
+            if (ref != nullptr) env->DeleteGlobalRef(ref);
+        delete op;
+    }
+
+    JavaVM* vm;
+    size_t batch;
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable ready;
+    std::deque<AsyncOp*> queue;
+    bool stopping = false;
 };
 
-extern "C" JNIEXPORT jint JNICALL Java_io_pmem_pmemkv_Database_database_1get_1buffer
-        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jint valuebytes, jobject value) {
-    auto engine = (pmemkv_db*) pointer;
-    const char* ckey = (char*) env->GetDirectBufferAddress(key);
-    ContextGetBuffer cxt = CONTEXT_GET_BUFFER;
-    auto status = pmemkv_get(engine, (char*) ckey, keybytes, CALLBACK_GET_BUFFER, &cxt);
-    if (status != PMEMKV_STATUS_OK && status != PMEMKV_STATUS_NOT_FOUND)
-        env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
-    return cxt.result;
+static void async_submit(JNIEnv* env, jlong pool, AsyncOp* op) {
+    op->status = PMEMKV_STATUS_OK;
+    op->result = 0;
+    op->thrown = nullptr;
+    for (auto ref : {&op->future, &op->key, &op->value, &op->callback})
+        if (*ref != nullptr) *ref = env->NewGlobalRef(*ref);
+    if (((AsyncPool*) pool)->submit(op)) return;
+
+    for (auto ref : {op->future, op->key, op->value, op->callback})
+        if (ref != nullptr) env->DeleteGlobalRef(ref);
+    delete op;
+    throw_exception(env, "Async pool is stopped");
 }
 
-struct ContextGet {
-    JNIEnv* env;
-    jbyteArray result;
-};
+extern "C" JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1async_1pool_1new
+        (JNIEnv* env, jobject obj, jint threads, jint batch) {
+    JavaVM* vm;
+    if (threads <= 0 || batch <= 0) {
+        throw_exception(env, "Invalid async pool size");
+        return 0;
+    }
+    if (env->GetJavaVM(&vm) != JNI_OK || !resolve_async_methods(env)) {
+        throw_exception(env, "Cannot initialize async pool");
+        return 0;
+    }
+    return (jlong) new AsyncPool(vm, threads, batch);
+}
 
-#define CONTEXT_GET {env, NULL}
+/* Throws when called from one of the pool's own workers. */
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1async_1pool_1delete
+        (JNIEnv* env, jobject obj, jlong pool) {
+    if ((AsyncPool*) pool == current_async_pool) {
+        throw_exception(env, "Async pool cannot be stopped from its own worker");
+        return;
+    }
+    delete (AsyncPool*) pool;
+}
 
-const auto CALLBACK_GET = [](const char* v, size_t vb, void *arg)  {
-    const auto c = ((ContextGet*) arg);
-    c->result = c->env->NewByteArray(vb);
-    c->env->SetByteArrayRegion(c->result, 0, vb, (jbyte*) v);
-};
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1async_1get_1buffer
+        (JNIEnv* env, jobject obj, jlong pool, jlong pointer, jint keybytes, jobject key, jint valuebytes, jobject value, jobject future) {
+    const char* ckey = direct_buffer(env, key, keybytes);
+    char* cvalue = ckey != nullptr ? direct_buffer(env, value, valuebytes) : nullptr;
+    if (cvalue == nullptr) return;
+    async_submit(env, pool, new AsyncOp{ASYNC_GET_BUFFER, (Database*) pointer, future, key, ckey, keybytes, value, cvalue, valuebytes});
+}
 
-extern "C" JNIEXPORT jbyteArray JNICALL Java_io_pmem_pmemkv_Database_database_1get_1bytes
-        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto ckey = env->GetByteArrayElements(key, NULL);
-    const auto ckeybytes = env->GetArrayLength(key);
-    ContextGet cxt = CONTEXT_GET;
-    auto status = pmemkv_get(engine, (char*) ckey, ckeybytes, CALLBACK_GET, &cxt);
-    env->ReleaseByteArrayElements(key, ckey, JNI_ABORT);
-    if (status != PMEMKV_STATUS_OK && status != PMEMKV_STATUS_NOT_FOUND)
-        env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
-    return cxt.result;
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1async_1put_1buffer
+        (JNIEnv* env, jobject obj, jlong pool, jlong pointer, jint keybytes, jobject key, jint valuebytes, jobject value, jobject future) {
+    const char* ckey = direct_buffer(env, key, keybytes);
+    char* cvalue = ckey != nullptr ? direct_buffer(env, value, valuebytes) : nullptr;
+    if (cvalue == nullptr) return;
+    async_submit(env, pool, new AsyncOp{ASYNC_PUT_BUFFER, (Database*) pointer, future, key, ckey, keybytes, value, cvalue, valuebytes});
 }
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1put_1buffer
-        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key, jint valuebytes, jobject value) {
-    auto engine = (pmemkv_db*) pointer;
-    const char* ckey = (char*) env->GetDirectBufferAddress(key);
-    const char* cvalue = (char*) env->GetDirectBufferAddress(value);
-    const auto result = pmemkv_put(engine, ckey, keybytes, cvalue, valuebytes);
-    if (result != PMEMKV_STATUS_OK)
-        env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1async_1remove_1buffer
+        (JNIEnv* env, jobject obj, jlong pool, jlong pointer, jint keybytes, jobject key, jobject future) {
+    const char* ckey = direct_buffer(env, key, keybytes);
+    if (ckey == nullptr) return;
+    async_submit(env, pool, new AsyncOp{ASYNC_REMOVE_BUFFER, (Database*) pointer, future, key, ckey, keybytes, nullptr, nullptr, 0});
 }
 
-extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1put_1bytes
-        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key, jbyteArray value) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto ckey = env->GetByteArrayElements(key, NULL);
-    const auto ckeybytes = env->GetArrayLength(key);
-    const auto cvalue = env->GetByteArrayElements(value, NULL);
-    const auto cvaluebytes = env->GetArrayLength(value);
-    const auto result = pmemkv_put(engine, (char*) ckey, ckeybytes, (char *) cvalue, cvaluebytes);
-    env->ReleaseByteArrayElements(key, ckey, JNI_ABORT);
-    env->ReleaseByteArrayElements(value, cvalue, JNI_ABORT);
-    if (result != PMEMKV_STATUS_OK)
-        env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
+extern "C" JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1async_1get_1all_1batch
+        (JNIEnv* env, jobject obj, jlong pool, jlong pointer, jint batchbytes, jobject batch, jobject callback, jobject future) {
+    char* cbatch = direct_buffer(env, batch, batchbytes);
+    if (cbatch == nullptr) return;
+    const auto mid = callback_method(env, callback, GET_ALL_BATCH_METHOD);
+    if (mid == nullptr) return;
+    async_submit(env, pool, new AsyncOp{ASYNC_GET_ALL_BATCH, (Database*) pointer, future, nullptr, nullptr, 0, batch, cbatch, batchbytes, callback, mid});
 }
 
-extern "C" JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1remove_1buffer
-        (JNIEnv* env, jobject obj, jlong pointer, jint keybytes, jobject key) {
-    auto engine = (pmemkv_db*) pointer;
-    const char* ckey = (char*) env->GetDirectBufferAddress(key);
-    const auto result = pmemkv_remove(engine, ckey, keybytes);
-    if (result != PMEMKV_STATUS_OK && result != PMEMKV_STATUS_NOT_FOUND)
-        env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
-    return result == PMEMKV_STATUS_OK;
+#define DATABASE_CLASS "io/pmem/pmemkv/Database"
+
+#define NATIVE_METHOD(name, signature, function) {(char*) name, (char*) signature, (void*) function}
+
+static const JNINativeMethod NATIVE_METHODS[] = {
+    NATIVE_METHOD("database_start", "(Ljava/lang/String;Ljava/lang/String;)J",
+            Java_io_pmem_pmemkv_Database_database_1start),
+    NATIVE_METHOD("database_start_config", "(Ljava/lang/String;J)J",
+            Java_io_pmem_pmemkv_Database_database_1start_1config),
+    NATIVE_METHOD("database_config_new", "()J",
+            Java_io_pmem_pmemkv_Database_database_1config_1new),
+    NATIVE_METHOD("database_config_delete", "(J)V",
+            Java_io_pmem_pmemkv_Database_database_1config_1delete),
+    NATIVE_METHOD("database_config_put_string", "(JLjava/lang/String;Ljava/lang/String;)V",
+            Java_io_pmem_pmemkv_Database_database_1config_1put_1string),
+    NATIVE_METHOD("database_config_put_uint64", "(JLjava/lang/String;J)V",
+            Java_io_pmem_pmemkv_Database_database_1config_1put_1uint64),
+    NATIVE_METHOD("database_config_put_int64", "(JLjava/lang/String;J)V",
+            Java_io_pmem_pmemkv_Database_database_1config_1put_1int64),
+    NATIVE_METHOD("database_config_put_object", "(JLjava/lang/String;J)V",
+            Java_io_pmem_pmemkv_Database_database_1config_1put_1object),
+    NATIVE_METHOD("database_stop", "(J)V",
+            Java_io_pmem_pmemkv_Database_database_1stop),
+    NATIVE_METHOD("database_get_keys_buffer", "(JLio/pmem/pmemkv/internal/AllBuffersJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1buffer),
+    NATIVE_METHOD("database_get_keys_buffer_limit", "(JJLio/pmem/pmemkv/internal/AllBuffersJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1buffer_1limit),
+    NATIVE_METHOD("database_get_keys_bytes", "(JLio/pmem/pmemkv/AllByteArraysCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1bytes),
+    NATIVE_METHOD("database_get_keys_bytes_limit", "(JJLio/pmem/pmemkv/AllByteArraysCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1bytes_1limit),
+    NATIVE_METHOD("database_get_keys_string", "(JLio/pmem/pmemkv/AllStringsCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1string),
+    NATIVE_METHOD("database_get_keys_string_limit", "(JJLio/pmem/pmemkv/AllStringsCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1string_1limit),
+    NATIVE_METHOD("database_get_keys_above_buffer", "(JILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/AllBuffersJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1buffer),
+    NATIVE_METHOD("database_get_keys_above_buffer_limit", "(JILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/AllBuffersJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1buffer_1limit),
+    NATIVE_METHOD("database_get_keys_above_bytes", "(J[BLio/pmem/pmemkv/AllByteArraysCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1bytes),
+    NATIVE_METHOD("database_get_keys_above_bytes_limit", "(J[BJLio/pmem/pmemkv/AllByteArraysCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1bytes_1limit),
+    NATIVE_METHOD("database_get_keys_above_string", "(J[BLio/pmem/pmemkv/AllStringsCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1string),
+    NATIVE_METHOD("database_get_keys_above_string_limit", "(J[BJLio/pmem/pmemkv/AllStringsCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1string_1limit),
+    NATIVE_METHOD("database_get_keys_below_buffer", "(JILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/AllBuffersJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1buffer),
+    NATIVE_METHOD("database_get_keys_below_buffer_limit", "(JILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/AllBuffersJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1buffer_1limit),
+    NATIVE_METHOD("database_get_keys_below_bytes", "(J[BLio/pmem/pmemkv/AllByteArraysCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1bytes),
+    NATIVE_METHOD("database_get_keys_below_bytes_limit", "(J[BJLio/pmem/pmemkv/AllByteArraysCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1bytes_1limit),
+    NATIVE_METHOD("database_get_keys_below_string", "(J[BLio/pmem/pmemkv/AllStringsCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1string),
+    NATIVE_METHOD("database_get_keys_below_string_limit", "(J[BJLio/pmem/pmemkv/AllStringsCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1string_1limit),
+    NATIVE_METHOD("database_get_keys_between_buffer", "(JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/AllBuffersJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1buffer),
+    NATIVE_METHOD("database_get_keys_between_buffer_limit", "(JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/AllBuffersJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1buffer_1limit),
+    NATIVE_METHOD("database_get_keys_between_bytes", "(J[B[BLio/pmem/pmemkv/AllByteArraysCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1bytes),
+    NATIVE_METHOD("database_get_keys_between_bytes_limit", "(J[B[BJLio/pmem/pmemkv/AllByteArraysCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1bytes_1limit),
+    NATIVE_METHOD("database_get_keys_between_string", "(J[B[BLio/pmem/pmemkv/AllStringsCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1string),
+    NATIVE_METHOD("database_get_keys_between_string_limit", "(J[B[BJLio/pmem/pmemkv/AllStringsCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1string_1limit),
+    NATIVE_METHOD("database_count_all", "(J)J",
+            Java_io_pmem_pmemkv_Database_database_1count_1all),
+    NATIVE_METHOD("database_count_above_buffer", "(JILjava/nio/ByteBuffer;)J",
+            Java_io_pmem_pmemkv_Database_database_1count_1above_1buffer),
+    NATIVE_METHOD("database_count_above_bytes", "(J[B)J",
+            Java_io_pmem_pmemkv_Database_database_1count_1above_1bytes),
+    NATIVE_METHOD("database_count_below_buffer", "(JILjava/nio/ByteBuffer;)J",
+            Java_io_pmem_pmemkv_Database_database_1count_1below_1buffer),
+    NATIVE_METHOD("database_count_below_bytes", "(J[B)J",
+            Java_io_pmem_pmemkv_Database_database_1count_1below_1bytes),
+    NATIVE_METHOD("database_count_between_buffer", "(JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;)J",
+            Java_io_pmem_pmemkv_Database_database_1count_1between_1buffer),
+    NATIVE_METHOD("database_count_between_bytes", "(J[B[B)J",
+            Java_io_pmem_pmemkv_Database_database_1count_1between_1bytes),
+    NATIVE_METHOD("database_get_all_buffer", "(JLio/pmem/pmemkv/internal/GetAllBufferJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1all_1buffer),
+    NATIVE_METHOD("database_get_all_buffer_limit", "(JJLio/pmem/pmemkv/internal/GetAllBufferJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1all_1buffer_1limit),
+    NATIVE_METHOD("database_get_all_bytes", "(JLio/pmem/pmemkv/GetAllByteArrayCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1all_1bytes),
+    NATIVE_METHOD("database_get_all_bytes_limit", "(JJLio/pmem/pmemkv/GetAllByteArrayCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1all_1bytes_1limit),
+    NATIVE_METHOD("database_get_all_string", "(JLio/pmem/pmemkv/GetAllStringCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1all_1string),
+    NATIVE_METHOD("database_get_all_string_limit", "(JJLio/pmem/pmemkv/GetAllStringCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1all_1string_1limit),
+    NATIVE_METHOD("database_get_above_buffer", "(JILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/GetAllBufferJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1above_1buffer),
+    NATIVE_METHOD("database_get_above_buffer_limit", "(JILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/GetAllBufferJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1above_1buffer_1limit),
+    NATIVE_METHOD("database_get_above_bytes", "(J[BLio/pmem/pmemkv/GetAllByteArrayCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1above_1bytes),
+    NATIVE_METHOD("database_get_above_bytes_limit", "(J[BJLio/pmem/pmemkv/GetAllByteArrayCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1above_1bytes_1limit),
+    NATIVE_METHOD("database_get_above_string", "(J[BLio/pmem/pmemkv/GetAllStringCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1above_1string),
+    NATIVE_METHOD("database_get_above_string_limit", "(J[BJLio/pmem/pmemkv/GetAllStringCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1above_1string_1limit),
+    NATIVE_METHOD("database_get_below_buffer", "(JILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/GetAllBufferJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1below_1buffer),
+    NATIVE_METHOD("database_get_below_buffer_limit", "(JILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/GetAllBufferJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1below_1buffer_1limit),
+    NATIVE_METHOD("database_get_below_bytes", "(J[BLio/pmem/pmemkv/GetAllByteArrayCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1below_1bytes),
+    NATIVE_METHOD("database_get_below_bytes_limit", "(J[BJLio/pmem/pmemkv/GetAllByteArrayCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1below_1bytes_1limit),
+    NATIVE_METHOD("database_get_below_string", "(J[BLio/pmem/pmemkv/GetAllStringCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1below_1string),
+    NATIVE_METHOD("database_get_below_string_limit", "(J[BJLio/pmem/pmemkv/GetAllStringCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1below_1string_1limit),
+    NATIVE_METHOD("database_get_between_buffer", "(JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/GetAllBufferJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1between_1buffer),
+    NATIVE_METHOD("database_get_between_buffer_limit", "(JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/GetAllBufferJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1between_1buffer_1limit),
+    NATIVE_METHOD("database_get_between_bytes", "(J[B[BLio/pmem/pmemkv/GetAllByteArrayCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1between_1bytes),
+    NATIVE_METHOD("database_get_between_bytes_limit", "(J[B[BJLio/pmem/pmemkv/GetAllByteArrayCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1between_1bytes_1limit),
+    NATIVE_METHOD("database_get_between_string", "(J[B[BLio/pmem/pmemkv/GetAllStringCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1between_1string),
+    NATIVE_METHOD("database_get_between_string_limit", "(J[B[BJLio/pmem/pmemkv/GetAllStringCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1between_1string_1limit),
+    NATIVE_METHOD("database_get_keys_prefix_buffer", "(JILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/AllBuffersJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1prefix_1buffer),
+    NATIVE_METHOD("database_get_keys_prefix_bytes", "(J[BJLio/pmem/pmemkv/AllByteArraysCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1keys_1prefix_1bytes),
+    NATIVE_METHOD("database_get_prefix_buffer", "(JILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/GetAllBufferJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1prefix_1buffer),
+    NATIVE_METHOD("database_get_prefix_bytes", "(J[BJLio/pmem/pmemkv/GetAllByteArrayCallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1prefix_1bytes),
+    NATIVE_METHOD("database_count_prefix_buffer", "(JILjava/nio/ByteBuffer;)J",
+            Java_io_pmem_pmemkv_Database_database_1count_1prefix_1buffer),
+    NATIVE_METHOD("database_count_prefix_bytes", "(J[B)J",
+            Java_io_pmem_pmemkv_Database_database_1count_1prefix_1bytes),
+    NATIVE_METHOD("database_get_all_batch", "(JILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/GetAllBatchJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1all_1batch),
+    NATIVE_METHOD("database_get_all_batch_limit", "(JILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/GetAllBatchJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1all_1batch_1limit),
+    NATIVE_METHOD("database_get_above_batch", "(JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/GetAllBatchJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1above_1batch),
+    NATIVE_METHOD("database_get_above_batch_limit", "(JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/GetAllBatchJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1above_1batch_1limit),
+    NATIVE_METHOD("database_get_below_batch", "(JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/GetAllBatchJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1below_1batch),
+    NATIVE_METHOD("database_get_below_batch_limit", "(JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/GetAllBatchJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1below_1batch_1limit),
+    NATIVE_METHOD("database_get_between_batch", "(JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/GetAllBatchJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1between_1batch),
+    NATIVE_METHOD("database_get_between_batch_limit", "(JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/GetAllBatchJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1between_1batch_1limit),
+    NATIVE_METHOD("database_get_between_parallel", "(JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;[Ljava/nio/ByteBuffer;[Lio/pmem/pmemkv/internal/GetAllBatchJNICallback;)V",
+            Java_io_pmem_pmemkv_Database_database_1get_1between_1parallel),
+    NATIVE_METHOD("database_cursor_open", "(J[BZ[B)J",
+            Java_io_pmem_pmemkv_Database_database_1cursor_1open),
+    NATIVE_METHOD("database_cursor_next", "(JIILjava/nio/ByteBuffer;)I",
+            Java_io_pmem_pmemkv_Database_database_1cursor_1next),
+    NATIVE_METHOD("database_cursor_key", "(J)[B",
+            Java_io_pmem_pmemkv_Database_database_1cursor_1key),
+    NATIVE_METHOD("database_cursor_close", "(J)V",
+            Java_io_pmem_pmemkv_Database_database_1cursor_1close),
+    NATIVE_METHOD("database_exists_buffer", "(JILjava/nio/ByteBuffer;)Z",
+            Java_io_pmem_pmemkv_Database_database_1exists_1buffer),
+    NATIVE_METHOD("database_exists_bytes", "(J[B)Z",
+            Java_io_pmem_pmemkv_Database_database_1exists_1bytes),
+    NATIVE_METHOD("database_get_buffer", "(JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;)I",
+            Java_io_pmem_pmemkv_Database_database_1get_1buffer),
+    NATIVE_METHOD("database_get_many_buffer", "(JIILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;)I",
+            Java_io_pmem_pmemkv_Database_database_1get_1many_1buffer),
+    NATIVE_METHOD("database_borrow_supported", "(J)Z",
+            Java_io_pmem_pmemkv_Database_database_1borrow_1supported),
+    NATIVE_METHOD("database_get_borrowed_buffer", "(JILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/BorrowedValueJNICallback;)Z",
+            Java_io_pmem_pmemkv_Database_database_1get_1borrowed_1buffer),
+    NATIVE_METHOD("database_get_bytes", "(J[B)[B",
+            Java_io_pmem_pmemkv_Database_database_1get_1bytes),
+    NATIVE_METHOD("database_get_into_bytes", "(J[B[BI)I",
+            Java_io_pmem_pmemkv_Database_database_1get_1into_1bytes),
+    NATIVE_METHOD("database_put_buffer", "(JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;)V",
+            Java_io_pmem_pmemkv_Database_database_1put_1buffer),
+    NATIVE_METHOD("database_put_bytes", "(J[B[B)V",
+            Java_io_pmem_pmemkv_Database_database_1put_1bytes),
+    NATIVE_METHOD("database_get_long", "(JJJ)J",
+            Java_io_pmem_pmemkv_Database_database_1get_1long),
+    NATIVE_METHOD("database_put_long", "(JJJ)V",
+            Java_io_pmem_pmemkv_Database_database_1put_1long),
+    NATIVE_METHOD("database_remove_long", "(JJ)Z",
+            Java_io_pmem_pmemkv_Database_database_1remove_1long),
+    NATIVE_METHOD("database_get_longs", "(J[J[JJ)I",
+            Java_io_pmem_pmemkv_Database_database_1get_1longs),
+    NATIVE_METHOD("database_put_longs", "(J[J[J)V",
+            Java_io_pmem_pmemkv_Database_database_1put_1longs),
+    NATIVE_METHOD("database_remove_longs", "(J[J)I",
+            Java_io_pmem_pmemkv_Database_database_1remove_1longs),
+    NATIVE_METHOD("database_increment_long", "(JJJ)J",
+            Java_io_pmem_pmemkv_Database_database_1increment_1long),
+    NATIVE_METHOD("database_increment_bytes", "(J[BJ)J",
+            Java_io_pmem_pmemkv_Database_database_1increment_1bytes),
+    NATIVE_METHOD("database_increment_longs", "(J[J[J)[J",
+            Java_io_pmem_pmemkv_Database_database_1increment_1longs),
+    NATIVE_METHOD("database_compare_and_set_long", "(JJJJ)Z",
+            Java_io_pmem_pmemkv_Database_database_1compare_1and_1set_1long),
+    NATIVE_METHOD("database_compare_and_set_bytes", "(J[B[B[B)Z",
+            Java_io_pmem_pmemkv_Database_database_1compare_1and_1set_1bytes),
+    NATIVE_METHOD("database_put_if_absent_long", "(JJJ)Z",
+            Java_io_pmem_pmemkv_Database_database_1put_1if_1absent_1long),
+    NATIVE_METHOD("database_put_if_absent_bytes", "(J[B[B)Z",
+            Java_io_pmem_pmemkv_Database_database_1put_1if_1absent_1bytes),
+    NATIVE_METHOD("database_write_batch", "(JIILjava/nio/ByteBuffer;)[B",
+            Java_io_pmem_pmemkv_Database_database_1write_1batch),
+    NATIVE_METHOD("database_remove_buffer", "(JILjava/nio/ByteBuffer;)Z",
+            Java_io_pmem_pmemkv_Database_database_1remove_1buffer),
+    NATIVE_METHOD("database_remove_bytes", "(J[B)Z",
+            Java_io_pmem_pmemkv_Database_database_1remove_1bytes),
+    NATIVE_METHOD("database_bulk_load_begin", "(J)J",
+            Java_io_pmem_pmemkv_Database_database_1bulk_1load_1begin),
+    NATIVE_METHOD("database_bulk_load_chunk", "(JILjava/nio/ByteBuffer;)V",
+            Java_io_pmem_pmemkv_Database_database_1bulk_1load_1chunk),
+    NATIVE_METHOD("database_bulk_load_stats", "(J)[J",
+            Java_io_pmem_pmemkv_Database_database_1bulk_1load_1stats),
+    NATIVE_METHOD("database_bulk_load_finish", "(J)[J",
+            Java_io_pmem_pmemkv_Database_database_1bulk_1load_1finish),
+    NATIVE_METHOD("database_export_snapshot", "(JLjava/lang/String;[B[B)J",
+            Java_io_pmem_pmemkv_Database_database_1export_1snapshot),
+    NATIVE_METHOD("database_import_snapshot", "(JLjava/lang/String;)J",
+            Java_io_pmem_pmemkv_Database_database_1import_1snapshot),
+    NATIVE_METHOD("database_snapshot_progress", "(J)J",
+            Java_io_pmem_pmemkv_Database_database_1snapshot_1progress),
+    NATIVE_METHOD("database_cache_stats", "(J)[J",
+            Java_io_pmem_pmemkv_Database_database_1cache_1stats),
+    NATIVE_METHOD("database_codec_stats", "(J)[J",
+            Java_io_pmem_pmemkv_Database_database_1codec_1stats),
+    NATIVE_METHOD("database_bloom_stats", "(J)[J",
+            Java_io_pmem_pmemkv_Database_database_1bloom_1stats),
+    NATIVE_METHOD("database_bloom_false_positive_rate", "(J)D",
+            Java_io_pmem_pmemkv_Database_database_1bloom_1false_1positive_1rate),
+    NATIVE_METHOD("database_bloom_rebuild", "(J)V",
+            Java_io_pmem_pmemkv_Database_database_1bloom_1rebuild),
+    NATIVE_METHOD("database_stats_names", "()[Ljava/lang/String;",
+            Java_io_pmem_pmemkv_Database_database_1stats_1names),
+    NATIVE_METHOD("database_stats", "()[J",
+            Java_io_pmem_pmemkv_Database_database_1stats),
+    NATIVE_METHOD("database_async_pool_new", "(II)J",
+            Java_io_pmem_pmemkv_Database_database_1async_1pool_1new),
+    NATIVE_METHOD("database_async_pool_delete", "(J)V",
+            Java_io_pmem_pmemkv_Database_database_1async_1pool_1delete),
+    NATIVE_METHOD("database_async_get_buffer", "(JJILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;Ljava/util/concurrent/CompletableFuture;)V",
+            Java_io_pmem_pmemkv_Database_database_1async_1get_1buffer),
+    NATIVE_METHOD("database_async_put_buffer", "(JJILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;Ljava/util/concurrent/CompletableFuture;)V",
+            Java_io_pmem_pmemkv_Database_database_1async_1put_1buffer),
+    NATIVE_METHOD("database_async_remove_buffer", "(JJILjava/nio/ByteBuffer;Ljava/util/concurrent/CompletableFuture;)V",
+            Java_io_pmem_pmemkv_Database_database_1async_1remove_1buffer),
+    NATIVE_METHOD("database_async_get_all_batch", "(JJILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/GetAllBatchJNICallback;Ljava/util/concurrent/CompletableFuture;)V",
+            Java_io_pmem_pmemkv_Database_database_1async_1get_1all_1batch),
+};
+
+/* Names of the methods declared by 'cls', through reflection. */
+static std::vector<std::string> declared_methods(JNIEnv* env, jclass cls) {
+    std::vector<std::string> names;
+    const auto class_class = env->FindClass("java/lang/Class");
+    const auto method_class = env->FindClass("java/lang/reflect/Method");
+    if (class_class == nullptr || method_class == nullptr) {
+        env->ExceptionClear();
+        return names;
+    }
+    const auto get_methods = env->GetMethodID(class_class, "getDeclaredMethods", "()[Ljava/lang/reflect/Method;");
+    const auto get_name = env->GetMethodID(method_class, "getName", "()Ljava/lang/String;");
+    const auto methods = get_methods != nullptr && get_name != nullptr ?
+            (jobjectArray) env->CallObjectMethod(cls, get_methods) : nullptr;
+    if (methods != nullptr) {
+        const auto count = env->GetArrayLength(methods);
+        for (jsize i = 0; i < count; i++) {
+            const auto method = env->GetObjectArrayElement(methods, i);
+            const auto name = (jstring) env->CallObjectMethod(method, get_name);
+            const char* cname = name != nullptr ? env->GetStringUTFChars(name, NULL) : nullptr;
+            if (cname != nullptr) {
+                names.push_back(cname);
+                env->ReleaseStringUTFChars(name, cname);
+            }
+            env->DeleteLocalRef(name);
+            env->DeleteLocalRef(method);
+        }
+        env->DeleteLocalRef(methods);
+    }
+    env->ExceptionClear();
+    env->DeleteLocalRef(class_class);
+    env->DeleteLocalRef(method_class);
+    return names;
 }
 
-extern "C" JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1remove_1bytes
-        (JNIEnv* env, jobject obj, jlong pointer, jbyteArray key) {
-    auto engine = (pmemkv_db*) pointer;
-    const auto ckey = env->GetByteArrayElements(key, NULL);
-    const auto ckeybytes = env->GetArrayLength(key);
-    const auto result = pmemkv_remove(engine, (char*) ckey, ckeybytes);
-    env->ReleaseByteArrayElements(key, ckey, JNI_ABORT);
-    if (result != PMEMKV_STATUS_OK && result != PMEMKV_STATUS_NOT_FOUND)
-        env->ThrowNew(env->FindClass(EXCEPTION_CLASS), pmemkv_errormsg());
-    return result == PMEMKV_STATUS_OK;
+/*
+ * Natives are registered one at a time, so a method that the loaded
+ * Database class does not declare (an older class) does not prevent the
+ * others from being bound. A method that the class declares under a
+ * different signature is a mismatch that symbol lookup would bind with the
+ * wrong arguments, so it is reported and fails the load.
+ */
+static bool register_natives(JNIEnv* env) {
+    const auto cls = env->FindClass(DATABASE_CLASS);
+    if (cls == nullptr) {
+        env->ExceptionClear();
+        return true;
+    }
+    bool ok = true;
+    bool listed = false;
+    std::vector<std::string> declared;
+    for (const auto& method : NATIVE_METHODS) {
+        if (env->RegisterNatives(cls, &method, 1) == JNI_OK) continue;
+        env->ExceptionClear();
+        if (!listed) {
+            declared = declared_methods(env, cls);
+            listed = true;
+        }
+        if (std::find(declared.begin(), declared.end(), method.name) != declared.end()) {
+            std::cerr << "[pmemkv-jni] " << DATABASE_CLASS << "." << method.name
+                      << " does not match the native signature " << method.signature << "\n";
+            ok = false;
+        } else {
+            LOG("Not declared: " << method.name << method.signature);
+        }
+    }
+    env->DeleteLocalRef(cls);
+    return ok;
+}
+
+extern "C" JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM* vm, void* reserved) {
+    JNIEnv* env;
+    if (vm->GetEnv((void**) &env, JNI_VERSION_1_6) != JNI_OK) return JNI_ERR;
+    jvm = vm;
+
+    exception_class = global_class(env, EXCEPTION_CLASS);
+    for (auto method : CALLBACK_METHODS) {
+        method->cls = global_class(env, method->classname);
+        if (method->cls == nullptr) continue;
+        method->mid = env->GetMethodID(method->cls, "process", method->signature);
+        if (method->mid == nullptr) env->ExceptionClear();
+    }
+    if (!resolve_buffer_methods(env)) env->ExceptionClear();
+    if (!register_natives(env)) return JNI_ERR;
+    return JNI_VERSION_1_6;
+}
+
+extern "C" JNIEXPORT void JNICALL JNI_OnUnload(JavaVM* vm, void* reserved) {
+    JNIEnv* env;
+    if (vm->GetEnv((void**) &env, JNI_VERSION_1_6) != JNI_OK) return;
+
+    for (auto method : CALLBACK_METHODS) {
+        if (method->cls != nullptr) env->DeleteGlobalRef(method->cls);
+        method->cls = nullptr;
+        method->mid = nullptr;
+    }
+    if (exception_class != nullptr) env->DeleteGlobalRef(exception_class);
+    exception_class = nullptr;
+    buffer_as_read_only = nullptr;
+    buffer_limit = nullptr;
+    for (auto cls : {async_methods.integer_class, async_methods.boolean_class})
+        if (cls != nullptr) env->DeleteGlobalRef(cls);
+    async_methods = {};
+    jvm = nullptr;
 }
@@ -15,6 +15,62 @@ extern "C" {
 JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1start
   (JNIEnv *, jobject, jstring, jstring);
 
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_start_config
+ * Signature: (Ljava/lang/String;J)J
+ */
+JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1start_1config
+  (JNIEnv *, jobject, jstring, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_config_new
+ * Signature: ()J
+ */
+JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1config_1new
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_config_delete
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1config_1delete
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_config_put_string
+ * Signature: (JLjava/lang/String;Ljava/lang/String;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1config_1put_1string
+  (JNIEnv *, jobject, jlong, jstring, jstring);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_config_put_uint64
+ * Signature: (JLjava/lang/String;J)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1config_1put_1uint64
+  (JNIEnv *, jobject, jlong, jstring, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_config_put_int64
+ * Signature: (JLjava/lang/String;J)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1config_1put_1int64
+  (JNIEnv *, jobject, jlong, jstring, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_config_put_object
+ * Signature: (JLjava/lang/String;J)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1config_1put_1object
+  (JNIEnv *, jobject, jlong, jstring, jlong);
+
 /*
  * Class:     io_pmem_pmemkv_Database
  * Method:    database_stop
@@ -25,7 +81,7 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1stop
 
 /*
  * Class:     io_pmem_pmemkv_Database
- * Method:    database_all_buffer
+ * Method:    database_get_keys_buffer
  * Signature: (JLio/pmem/pmemkv/internal/AllBuffersJNICallback;)V
  */
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1buffer
@@ -33,7 +89,15 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1buffer
 
 /*
  * Class:     io_pmem_pmemkv_Database
- * Method:    database_all_bytes
+ * Method:    database_get_keys_buffer_limit
+ * Signature: (JJLio/pmem/pmemkv/internal/AllBuffersJNICallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1buffer_1limit
+  (JNIEnv *, jobject, jlong, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_keys_bytes
  * Signature: (JLio/pmem/pmemkv/AllByteArraysCallback;)V
  */
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1bytes
@@ -41,7 +105,15 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1bytes
 
 /*
  * Class:     io_pmem_pmemkv_Database
- * Method:    database_all_string
+ * Method:    database_get_keys_bytes_limit
+ * Signature: (JJLio/pmem/pmemkv/AllByteArraysCallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1bytes_1limit
+  (JNIEnv *, jobject, jlong, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_keys_string
  * Signature: (JLio/pmem/pmemkv/AllStringsCallback;)V
  */
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1string
@@ -49,7 +121,15 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1string
 
 /*
  * Class:     io_pmem_pmemkv_Database
- * Method:    database_all_above_buffer
+ * Method:    database_get_keys_string_limit
+ * Signature: (JJLio/pmem/pmemkv/AllStringsCallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1string_1limit
+  (JNIEnv *, jobject, jlong, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_keys_above_buffer
  * Signature: (JILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/AllBuffersJNICallback;)V
  */
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1buffer
@@ -57,7 +137,15 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1
 
 /*
  * Class:     io_pmem_pmemkv_Database
- * Method:    database_all_above_bytes
+ * Method:    database_get_keys_above_buffer_limit
+ * Signature: (JILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/AllBuffersJNICallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1buffer_1limit
+  (JNIEnv *, jobject, jlong, jint, jobject, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_keys_above_bytes
  * Signature: (J[BLio/pmem/pmemkv/AllByteArraysCallback;)V
  */
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1bytes
@@ -65,7 +153,15 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1
 
 /*
  * Class:     io_pmem_pmemkv_Database
- * Method:    database_all_above_string
+ * Method:    database_get_keys_above_bytes_limit
+ * Signature: (J[BJLio/pmem/pmemkv/AllByteArraysCallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1bytes_1limit
+  (JNIEnv *, jobject, jlong, jbyteArray, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_keys_above_string
  * Signature: (J[BLio/pmem/pmemkv/AllStringsCallback;)V
  */
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1string
@@ -73,7 +169,15 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1
 
 /*
  * Class:     io_pmem_pmemkv_Database
- * Method:    database_all_below_buffer
+ * Method:    database_get_keys_above_string_limit
+ * Signature: (J[BJLio/pmem/pmemkv/AllStringsCallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1above_1string_1limit
+  (JNIEnv *, jobject, jlong, jbyteArray, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_keys_below_buffer
  * Signature: (JILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/AllBuffersJNICallback;)V
  */
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1buffer
@@ -81,7 +185,15 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1
 
 /*
  * Class:     io_pmem_pmemkv_Database
- * Method:    database_all_below_bytes
+ * Method:    database_get_keys_below_buffer_limit
+ * Signature: (JILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/AllBuffersJNICallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1buffer_1limit
+  (JNIEnv *, jobject, jlong, jint, jobject, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_keys_below_bytes
  * Signature: (J[BLio/pmem/pmemkv/AllByteArraysCallback;)V
  */
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1bytes
@@ -89,7 +201,15 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1
 
 /*
  * Class:     io_pmem_pmemkv_Database
- * Method:    database_all_below_string
+ * Method:    database_get_keys_below_bytes_limit
+ * Signature: (J[BJLio/pmem/pmemkv/AllByteArraysCallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1bytes_1limit
+  (JNIEnv *, jobject, jlong, jbyteArray, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_keys_below_string
  * Signature: (J[BLio/pmem/pmemkv/AllStringsCallback;)V
  */
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1string
@@ -97,7 +217,15 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1
 
 /*
  * Class:     io_pmem_pmemkv_Database
- * Method:    database_all_between_buffer
+ * Method:    database_get_keys_below_string_limit
+ * Signature: (J[BJLio/pmem/pmemkv/AllStringsCallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1below_1string_1limit
+  (JNIEnv *, jobject, jlong, jbyteArray, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_keys_between_buffer
  * Signature: (JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/AllBuffersJNICallback;)V
  */
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1buffer
@@ -105,7 +233,15 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1between
 
 /*
  * Class:     io_pmem_pmemkv_Database
- * Method:    database_all_between_bytes
+ * Method:    database_get_keys_between_buffer_limit
+ * Signature: (JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/AllBuffersJNICallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1buffer_1limit
+  (JNIEnv *, jobject, jlong, jint, jobject, jint, jobject, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_keys_between_bytes
  * Signature: (J[B[BLio/pmem/pmemkv/AllByteArraysCallback;)V
  */
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1bytes
@@ -113,7 +249,15 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1between
 
 /*
  * Class:     io_pmem_pmemkv_Database
- * Method:    database_all_between_string
+ * Method:    database_get_keys_between_bytes_limit
+ * Signature: (J[B[BJLio/pmem/pmemkv/AllByteArraysCallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1bytes_1limit
+  (JNIEnv *, jobject, jlong, jbyteArray, jbyteArray, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_keys_between_string
  * Signature: (J[B[BLio/pmem/pmemkv/AllStringsCallback;)V
  */
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1string
@@ -121,7 +265,15 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1between
 
 /*
  * Class:     io_pmem_pmemkv_Database
- * Method:    database_count
+ * Method:    database_get_keys_between_string_limit
+ * Signature: (J[B[BJLio/pmem/pmemkv/AllStringsCallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1between_1string_1limit
+  (JNIEnv *, jobject, jlong, jbyteArray, jbyteArray, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_count_all
  * Signature: (J)J
  */
 JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1count_1all
@@ -183,6 +335,14 @@ JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1count_1between_1b
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1buffer
   (JNIEnv *, jobject, jlong, jobject);
 
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_all_buffer_limit
+ * Signature: (JJLio/pmem/pmemkv/internal/GetAllBufferJNICallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1buffer_1limit
+  (JNIEnv *, jobject, jlong, jlong, jobject);
+
 /*
  * Class:     io_pmem_pmemkv_Database
  * Method:    database_get_all_bytes
@@ -191,6 +351,14 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1buffer
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1bytes
   (JNIEnv *, jobject, jlong, jobject);
 
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_all_bytes_limit
+ * Signature: (JJLio/pmem/pmemkv/GetAllByteArrayCallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1bytes_1limit
+  (JNIEnv *, jobject, jlong, jlong, jobject);
+
 /*
  * Class:     io_pmem_pmemkv_Database
  * Method:    database_get_all_string
@@ -199,6 +367,14 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1bytes
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1string
   (JNIEnv *, jobject, jlong, jobject);
 
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_all_string_limit
+ * Signature: (JJLio/pmem/pmemkv/GetAllStringCallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1string_1limit
+  (JNIEnv *, jobject, jlong, jlong, jobject);
+
 /*
  * Class:     io_pmem_pmemkv_Database
  * Method:    database_get_above_buffer
@@ -207,6 +383,14 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1string
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1buffer
   (JNIEnv *, jobject, jlong, jint, jobject, jobject);
 
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_above_buffer_limit
+ * Signature: (JILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/GetAllBufferJNICallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1buffer_1limit
+  (JNIEnv *, jobject, jlong, jint, jobject, jlong, jobject);
+
 /*
  * Class:     io_pmem_pmemkv_Database
  * Method:    database_get_above_bytes
@@ -215,6 +399,14 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1buffer
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1bytes
   (JNIEnv *, jobject, jlong, jbyteArray, jobject);
 
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_above_bytes_limit
+ * Signature: (J[BJLio/pmem/pmemkv/GetAllByteArrayCallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1bytes_1limit
+  (JNIEnv *, jobject, jlong, jbyteArray, jlong, jobject);
+
 /*
  * Class:     io_pmem_pmemkv_Database
  * Method:    database_get_above_string
@@ -223,6 +415,14 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1bytes
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1string
   (JNIEnv *, jobject, jlong, jbyteArray, jobject);
 
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_above_string_limit
+ * Signature: (J[BJLio/pmem/pmemkv/GetAllStringCallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1string_1limit
+  (JNIEnv *, jobject, jlong, jbyteArray, jlong, jobject);
+
 /*
  * Class:     io_pmem_pmemkv_Database
  * Method:    database_get_below_buffer
@@ -231,6 +431,14 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1string
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1buffer
   (JNIEnv *, jobject, jlong, jint, jobject, jobject);
 
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_below_buffer_limit
+ * Signature: (JILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/GetAllBufferJNICallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1buffer_1limit
+  (JNIEnv *, jobject, jlong, jint, jobject, jlong, jobject);
+
 /*
  * Class:     io_pmem_pmemkv_Database
  * Method:    database_get_below_bytes
@@ -239,6 +447,14 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1buffer
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1bytes
   (JNIEnv *, jobject, jlong, jbyteArray, jobject);
 
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_below_bytes_limit
+ * Signature: (J[BJLio/pmem/pmemkv/GetAllByteArrayCallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1bytes_1limit
+  (JNIEnv *, jobject, jlong, jbyteArray, jlong, jobject);
+
 /*
  * Class:     io_pmem_pmemkv_Database
  * Method:    database_get_below_string
@@ -247,6 +463,14 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1bytes
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1string
   (JNIEnv *, jobject, jlong, jbyteArray, jobject);
 
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_below_string_limit
+ * Signature: (J[BJLio/pmem/pmemkv/GetAllStringCallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1string_1limit
+  (JNIEnv *, jobject, jlong, jbyteArray, jlong, jobject);
+
 /*
  * Class:     io_pmem_pmemkv_Database
  * Method:    database_get_between_buffer
@@ -255,6 +479,14 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1string
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1buffer
   (JNIEnv *, jobject, jlong, jint, jobject, jint, jobject, jobject);
 
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_between_buffer_limit
+ * Signature: (JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/GetAllBufferJNICallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1buffer_1limit
+  (JNIEnv *, jobject, jlong, jint, jobject, jint, jobject, jlong, jobject);
+
 /*
  * Class:     io_pmem_pmemkv_Database
  * Method:    database_get_between_bytes
@@ -263,6 +495,14 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1buff
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1bytes
   (JNIEnv *, jobject, jlong, jbyteArray, jbyteArray, jobject);
 
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_between_bytes_limit
+ * Signature: (J[B[BJLio/pmem/pmemkv/GetAllByteArrayCallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1bytes_1limit
+  (JNIEnv *, jobject, jlong, jbyteArray, jbyteArray, jlong, jobject);
+
 /*
  * Class:     io_pmem_pmemkv_Database
  * Method:    database_get_between_string
@@ -271,6 +511,166 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1byte
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1string
   (JNIEnv *, jobject, jlong, jbyteArray, jbyteArray, jobject);
 
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_between_string_limit
+ * Signature: (J[B[BJLio/pmem/pmemkv/GetAllStringCallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1string_1limit
+  (JNIEnv *, jobject, jlong, jbyteArray, jbyteArray, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_keys_prefix_buffer
+ * Signature: (JILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/AllBuffersJNICallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1prefix_1buffer
+  (JNIEnv *, jobject, jlong, jint, jobject, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_keys_prefix_bytes
+ * Signature: (J[BJLio/pmem/pmemkv/AllByteArraysCallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1keys_1prefix_1bytes
+  (JNIEnv *, jobject, jlong, jbyteArray, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_prefix_buffer
+ * Signature: (JILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/GetAllBufferJNICallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1prefix_1buffer
+  (JNIEnv *, jobject, jlong, jint, jobject, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_prefix_bytes
+ * Signature: (J[BJLio/pmem/pmemkv/GetAllByteArrayCallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1prefix_1bytes
+  (JNIEnv *, jobject, jlong, jbyteArray, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_count_prefix_buffer
+ * Signature: (JILjava/nio/ByteBuffer;)J
+ */
+JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1count_1prefix_1buffer
+  (JNIEnv *, jobject, jlong, jint, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_count_prefix_bytes
+ * Signature: (J[B)J
+ */
+JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1count_1prefix_1bytes
+  (JNIEnv *, jobject, jlong, jbyteArray);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_all_batch
+ * Signature: (JILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/GetAllBatchJNICallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1batch
+  (JNIEnv *, jobject, jlong, jint, jobject, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_all_batch_limit
+ * Signature: (JILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/GetAllBatchJNICallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1all_1batch_1limit
+  (JNIEnv *, jobject, jlong, jint, jobject, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_above_batch
+ * Signature: (JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/GetAllBatchJNICallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1batch
+  (JNIEnv *, jobject, jlong, jint, jobject, jint, jobject, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_above_batch_limit
+ * Signature: (JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/GetAllBatchJNICallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1above_1batch_1limit
+  (JNIEnv *, jobject, jlong, jint, jobject, jint, jobject, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_below_batch
+ * Signature: (JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/GetAllBatchJNICallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1batch
+  (JNIEnv *, jobject, jlong, jint, jobject, jint, jobject, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_below_batch_limit
+ * Signature: (JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/GetAllBatchJNICallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1below_1batch_1limit
+  (JNIEnv *, jobject, jlong, jint, jobject, jint, jobject, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_between_batch
+ * Signature: (JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/GetAllBatchJNICallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1batch
+  (JNIEnv *, jobject, jlong, jint, jobject, jint, jobject, jint, jobject, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_between_batch_limit
+ * Signature: (JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;JLio/pmem/pmemkv/internal/GetAllBatchJNICallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1batch_1limit
+  (JNIEnv *, jobject, jlong, jint, jobject, jint, jobject, jint, jobject, jlong, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_between_parallel
+ * Signature: (JILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;[Ljava/nio/ByteBuffer;[Lio/pmem/pmemkv/internal/GetAllBatchJNICallback;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1get_1between_1parallel
+  (JNIEnv *, jobject, jlong, jint, jobject, jint, jobject, jobjectArray, jobjectArray);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_cursor_open
+ * Signature: (J[BZ[B)J
+ */
+JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1cursor_1open
+  (JNIEnv *, jobject, jlong, jbyteArray, jboolean, jbyteArray);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_cursor_next
+ * Signature: (JIILjava/nio/ByteBuffer;)I
+ */
+JNIEXPORT jint JNICALL Java_io_pmem_pmemkv_Database_database_1cursor_1next
+  (JNIEnv *, jobject, jlong, jint, jint, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_cursor_key
+ * Signature: (J)[B
+ */
+JNIEXPORT jbyteArray JNICALL Java_io_pmem_pmemkv_Database_database_1cursor_1key
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_cursor_close
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1cursor_1close
+  (JNIEnv *, jobject, jlong);
+
 /*
  * Class:     io_pmem_pmemkv_Database
  * Method:    database_exists_buffer
@@ -295,6 +695,30 @@ JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1exists_1bytes
 JNIEXPORT jint JNICALL Java_io_pmem_pmemkv_Database_database_1get_1buffer
   (JNIEnv *, jobject, jlong, jint, jobject, jint, jobject);
 
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_many_buffer
+ * Signature: (JIILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;)I
+ */
+JNIEXPORT jint JNICALL Java_io_pmem_pmemkv_Database_database_1get_1many_1buffer
+  (JNIEnv *, jobject, jlong, jint, jint, jobject, jint, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_borrow_supported
+ * Signature: (J)Z
+ */
+JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1borrow_1supported
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_borrowed_buffer
+ * Signature: (JILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/BorrowedValueJNICallback;)Z
+ */
+JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1get_1borrowed_1buffer
+  (JNIEnv *, jobject, jlong, jint, jobject, jobject);
+
 /*
  * Class:     io_pmem_pmemkv_Database
  * Method:    database_get_bytes
@@ -303,6 +727,14 @@ JNIEXPORT jint JNICALL Java_io_pmem_pmemkv_Database_database_1get_1buffer
 JNIEXPORT jbyteArray JNICALL Java_io_pmem_pmemkv_Database_database_1get_1bytes
   (JNIEnv *, jobject, jlong, jbyteArray);
 
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_into_bytes
+ * Signature: (J[B[BI)I
+ */
+JNIEXPORT jint JNICALL Java_io_pmem_pmemkv_Database_database_1get_1into_1bytes
+  (JNIEnv *, jobject, jlong, jbyteArray, jbyteArray, jint);
+
 /*
  * Class:     io_pmem_pmemkv_Database
  * Method:    database_put_buffer
@@ -319,6 +751,118 @@ JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1put_1buffer
 JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1put_1bytes
   (JNIEnv *, jobject, jlong, jbyteArray, jbyteArray);
 
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_long
+ * Signature: (JJJ)J
+ */
+JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1get_1long
+  (JNIEnv *, jobject, jlong, jlong, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_put_long
+ * Signature: (JJJ)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1put_1long
+  (JNIEnv *, jobject, jlong, jlong, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_remove_long
+ * Signature: (JJ)Z
+ */
+JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1remove_1long
+  (JNIEnv *, jobject, jlong, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_get_longs
+ * Signature: (J[J[JJ)I
+ */
+JNIEXPORT jint JNICALL Java_io_pmem_pmemkv_Database_database_1get_1longs
+  (JNIEnv *, jobject, jlong, jlongArray, jlongArray, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_put_longs
+ * Signature: (J[J[J)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1put_1longs
+  (JNIEnv *, jobject, jlong, jlongArray, jlongArray);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_remove_longs
+ * Signature: (J[J)I
+ */
+JNIEXPORT jint JNICALL Java_io_pmem_pmemkv_Database_database_1remove_1longs
+  (JNIEnv *, jobject, jlong, jlongArray);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_increment_long
+ * Signature: (JJJ)J
+ */
+JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1increment_1long
+  (JNIEnv *, jobject, jlong, jlong, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_increment_bytes
+ * Signature: (J[BJ)J
+ */
+JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1increment_1bytes
+  (JNIEnv *, jobject, jlong, jbyteArray, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_increment_longs
+ * Signature: (J[J[J)[J
+ */
+JNIEXPORT jlongArray JNICALL Java_io_pmem_pmemkv_Database_database_1increment_1longs
+  (JNIEnv *, jobject, jlong, jlongArray, jlongArray);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_compare_and_set_long
+ * Signature: (JJJJ)Z
+ */
+JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1compare_1and_1set_1long
+  (JNIEnv *, jobject, jlong, jlong, jlong, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_compare_and_set_bytes
+ * Signature: (J[B[B[B)Z
+ */
+JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1compare_1and_1set_1bytes
+  (JNIEnv *, jobject, jlong, jbyteArray, jbyteArray, jbyteArray);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_put_if_absent_long
+ * Signature: (JJJ)Z
+ */
+JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1put_1if_1absent_1long
+  (JNIEnv *, jobject, jlong, jlong, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_put_if_absent_bytes
+ * Signature: (J[B[B)Z
+ */
+JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1put_1if_1absent_1bytes
+  (JNIEnv *, jobject, jlong, jbyteArray, jbyteArray);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_write_batch
+ * Signature: (JIILjava/nio/ByteBuffer;)[B
+ */
+JNIEXPORT jbyteArray JNICALL Java_io_pmem_pmemkv_Database_database_1write_1batch
+  (JNIEnv *, jobject, jlong, jint, jint, jobject);
+
 /*
  * Class:     io_pmem_pmemkv_Database
  * Method:    database_remove_buffer
@@ -335,6 +879,166 @@ JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1remove_1buffer
 JNIEXPORT jboolean JNICALL Java_io_pmem_pmemkv_Database_database_1remove_1bytes
   (JNIEnv *, jobject, jlong, jbyteArray);
 
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_bulk_load_begin
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1bulk_1load_1begin
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_bulk_load_chunk
+ * Signature: (JILjava/nio/ByteBuffer;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1bulk_1load_1chunk
+  (JNIEnv *, jobject, jlong, jint, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_bulk_load_stats
+ * Signature: (J)[J
+ */
+JNIEXPORT jlongArray JNICALL Java_io_pmem_pmemkv_Database_database_1bulk_1load_1stats
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_bulk_load_finish
+ * Signature: (J)[J
+ */
+JNIEXPORT jlongArray JNICALL Java_io_pmem_pmemkv_Database_database_1bulk_1load_1finish
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_export_snapshot
+ * Signature: (JLjava/lang/String;[B[B)J
+ */
+JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1export_1snapshot
+  (JNIEnv *, jobject, jlong, jstring, jbyteArray, jbyteArray);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_import_snapshot
+ * Signature: (JLjava/lang/String;)J
+ */
+JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1import_1snapshot
+  (JNIEnv *, jobject, jlong, jstring);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_snapshot_progress
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1snapshot_1progress
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_cache_stats
+ * Signature: (J)[J
+ */
+JNIEXPORT jlongArray JNICALL Java_io_pmem_pmemkv_Database_database_1cache_1stats
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_codec_stats
+ * Signature: (J)[J
+ */
+JNIEXPORT jlongArray JNICALL Java_io_pmem_pmemkv_Database_database_1codec_1stats
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_bloom_stats
+ * Signature: (J)[J
+ */
+JNIEXPORT jlongArray JNICALL Java_io_pmem_pmemkv_Database_database_1bloom_1stats
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_bloom_false_positive_rate
+ * Signature: (J)D
+ */
+JNIEXPORT jdouble JNICALL Java_io_pmem_pmemkv_Database_database_1bloom_1false_1positive_1rate
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_bloom_rebuild
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1bloom_1rebuild
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_stats_names
+ * Signature: ()[Ljava/lang/String;
+ */
+JNIEXPORT jobjectArray JNICALL Java_io_pmem_pmemkv_Database_database_1stats_1names
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_stats
+ * Signature: ()[J
+ */
+JNIEXPORT jlongArray JNICALL Java_io_pmem_pmemkv_Database_database_1stats
+  (JNIEnv *, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_async_pool_new
+ * Signature: (II)J
+ */
+JNIEXPORT jlong JNICALL Java_io_pmem_pmemkv_Database_database_1async_1pool_1new
+  (JNIEnv *, jobject, jint, jint);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_async_pool_delete
+ * Signature: (J)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1async_1pool_1delete
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_async_get_buffer
+ * Signature: (JJILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;Ljava/util/concurrent/CompletableFuture;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1async_1get_1buffer
+  (JNIEnv *, jobject, jlong, jlong, jint, jobject, jint, jobject, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_async_put_buffer
+ * Signature: (JJILjava/nio/ByteBuffer;ILjava/nio/ByteBuffer;Ljava/util/concurrent/CompletableFuture;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1async_1put_1buffer
+  (JNIEnv *, jobject, jlong, jlong, jint, jobject, jint, jobject, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_async_remove_buffer
+ * Signature: (JJILjava/nio/ByteBuffer;Ljava/util/concurrent/CompletableFuture;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1async_1remove_1buffer
+  (JNIEnv *, jobject, jlong, jlong, jint, jobject, jobject);
+
+/*
+ * Class:     io_pmem_pmemkv_Database
+ * Method:    database_async_get_all_batch
+ * Signature: (JJILjava/nio/ByteBuffer;Lio/pmem/pmemkv/internal/GetAllBatchJNICallback;Ljava/util/concurrent/CompletableFuture;)V
+ */
+JNIEXPORT void JNICALL Java_io_pmem_pmemkv_Database_database_1async_1get_1all_1batch
+  (JNIEnv *, jobject, jlong, jlong, jint, jobject, jobject, jobject);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,358 @@
+/*
+ * Copyright 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Drives the exported entry points directly from native threads attached
+ * to an embedded JVM, so that the numbers include the JNI transitions but
+ * no Java code. Entry points taking Java callback objects (the scans) are
+ * not covered, as the pmemkv-java classes are not on the class path.
+ *
+ * Every comma-separated combination of engine, key size, value size and
+ * thread count is run on a fresh pool. Engines listed in --persistent open
+ * a pool file, --path or BENCH_POOL in --dir, which is removed before and
+ * after the run; the others get --dir itself as their path. Run it with
+ * PMEM_IS_PMEM_FORCE=1 when the pool is on a regular file system, as
+ * "make bench" does.
+ *
+ * Only the entry point is timed: keys are written to the key buffer or
+ * byte[] before the clock starts.
+ *
+ *   pmemkv-jni_bench --engines=cmap,vsmap --dir=/dev/shm --keys=100000
+ *                    --key_bytes=16 --value_bytes=8,128,1024 --threads=1,4
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <jni.h>
+#include "io_pmem_pmemkv_Database.h"
+
+#define BENCH_POOL "pmemkv-jni_bench.pool"
+#define BENCH_POOL_OVERHEAD 256
+#define BENCH_MIN_POOL_BYTES (64 * 1024 * 1024)
+#define BENCH_GET_MANY 16
+
+struct Options {
+    std::vector<std::string> engines = {"cmap"};
+    std::vector<std::string> persistent = {"cmap", "csmap", "radix", "stree", "tree3"};
+    std::string dir = "/tmp";
+    std::string path;
+    size_t keys = 100000;
+    std::vector<size_t> key_bytes = {16};
+    std::vector<size_t> value_bytes = {8, 128, 1024};
+    std::vector<size_t> threads = {1, 4};
+};
+
+struct Config {
+    std::string engine;
+    size_t keys;
+    size_t key_bytes;
+    size_t value_bytes;
+    size_t threads;
+};
+
+/* What one thread touches: keys [first, last) and its own buffers. */
+struct Worker {
+    JNIEnv* env;
+    jlong db;
+    const Config* config;
+    size_t first;
+    size_t last;
+    std::vector<char> key;
+    std::vector<char> keys;
+    std::vector<char> value;
+    jobject key_buffer;
+    jobject keys_buffer;
+    jobject value_buffer;
+    jbyteArray key_array;
+    jbyteArray value_array;
+    std::vector<uint64_t> latencies;
+};
+
+static JavaVM* vm;
+
+static std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> result;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) result.push_back(item);
+    return result;
+}
+
+static std::vector<size_t> split_sizes(const std::string& list) {
+    std::vector<size_t> result;
+    for (const auto& item : split(list)) result.push_back(std::stoul(item));
+    return result;
+}
+
+static bool parse(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const auto eq = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos) return false;
+        const auto name = arg.substr(2, eq - 2);
+        const auto value = arg.substr(eq + 1);
+        if (name == "engines") options.engines = split(value);
+        else if (name == "persistent") options.persistent = split(value);
+        else if (name == "dir") options.dir = value;
+        else if (name == "path") options.path = value;
+        else if (name == "keys") options.keys = std::stoul(value);
+        else if (name == "key_bytes") options.key_bytes = split_sizes(value);
+        else if (name == "value_bytes") options.value_bytes = split_sizes(value);
+        else if (name == "threads") options.threads = split_sizes(value);
+        else return false;
+    }
+    return true;
+}
+
+/* Fixed-width decimal key, so that keys of any size stay unique and sorted. */
+static void make_key(size_t i, char* key, size_t key_bytes) {
+    std::memset(key, '0', key_bytes);
+    for (size_t p = key_bytes; p > 0 && i > 0; p--, i /= 10) key[p - 1] = '0' + i % 10;
+}
+
+static void check(JNIEnv* env, const char* op) {
+    if (!env->ExceptionCheck()) return;
+    std::cerr << op << " failed" << std::endl;
+    env->ExceptionDescribe();
+    std::exit(1);
+}
+
+static void set_key(Worker& w, size_t i) {
+    make_key(i, w.key.data(), w.key.size());
+    w.env->SetByteArrayRegion(w.key_array, 0, w.key.size(), (jbyte*) w.key.data());
+}
+
+static uint64_t percentile(const std::vector<uint64_t>& sorted, double fraction) {
+    if (sorted.empty()) return 0;
+    return sorted[std::min(sorted.size() - 1, (size_t) (fraction * sorted.size()))];
+}
+
+/*
+ * Runs 'op' once per key on every thread and prints throughput and
+ * latency. 'prepare', if given, fills the worker's key buffers for the
+ * call outside the timed region. Both get the worker and the key index.
+ */
+static void run(const char* name, std::vector<Worker>& workers, size_t per_call,
+                const std::function<void(Worker&, size_t)>& prepare,
+                const std::function<void(Worker&, size_t)>& op) {
+    std::vector<std::thread> threads;
+    const auto start = std::chrono::steady_clock::now();
+    for (auto& w : workers) {
+        threads.emplace_back([&w, &prepare, &op, per_call] {
+            vm->AttachCurrentThread((void**) &w.env, nullptr);
+            w.env->PushLocalFrame(16);
+            w.latencies.clear();
+            for (size_t i = w.first; i < w.last; i += per_call) {
+                if (prepare) prepare(w, i);
+                const auto t0 = std::chrono::steady_clock::now();
+                op(w, i);
+                const auto t1 = std::chrono::steady_clock::now();
+                w.latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+            }
+            w.env->PopLocalFrame(nullptr);
+            vm->DetachCurrentThread();
+        });
+    }
+    for (auto& t : threads) t.join();
+    const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<uint64_t> latencies;
+    for (const auto& w : workers) latencies.insert(latencies.end(), w.latencies.begin(), w.latencies.end());
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << std::setw(22) << name << std::fixed << std::setprecision(0)
+              << std::setw(14) << latencies.size() / seconds
+              << std::setw(10) << percentile(latencies, 0.5)
+              << std::setw(10) << percentile(latencies, 0.99)
+              << std::setw(10) << percentile(latencies, 0.999)
+              << std::setw(10) << (latencies.empty() ? 0 : latencies.back()) << std::endl;
+}
+
+static void bench(JNIEnv* env, const Options& options, const Config& config) {
+    const auto& engines = options.persistent;
+    const bool persistent = std::find(engines.begin(), engines.end(), config.engine) != engines.end();
+    const auto pool = options.path.empty() ? options.dir + "/" + BENCH_POOL : options.path;
+    const auto path = persistent ? pool : options.dir;
+    if (persistent) std::remove(path.c_str());
+    const size_t pool_bytes = std::max((size_t) BENCH_MIN_POOL_BYTES,
+            2 * config.keys * (config.key_bytes + config.value_bytes + BENCH_POOL_OVERHEAD));
+    const auto json = "{\"path\":\"" + path + "\",\"size\":" + std::to_string(pool_bytes) + "}";
+
+    const auto jengine = env->NewStringUTF(config.engine.c_str());
+    const auto jconfig = env->NewStringUTF(json.c_str());
+    const auto db = Java_io_pmem_pmemkv_Database_database_1start(env, nullptr, jengine, jconfig);
+    check(env, "database_start");
+    env->DeleteLocalRef(jengine);
+    env->DeleteLocalRef(jconfig);
+
+    std::cout << "engine=" << config.engine << " keys=" << config.keys << " key_bytes=" << config.key_bytes
+              << " value_bytes=" << config.value_bytes << " threads=" << config.threads << std::endl;
+    std::cout << std::setw(22) << "entry point" << std::setw(14) << "ops/sec" << std::setw(10) << "p50 ns"
+              << std::setw(10) << "p99 ns" << std::setw(10) << "p999 ns" << std::setw(10) << "max ns" << std::endl;
+
+    std::vector<Worker> workers(config.threads);
+    const size_t per_call_bytes = BENCH_GET_MANY * (config.key_bytes + config.value_bytes + 16);
+    for (size_t t = 0; t < config.threads; t++) {
+        auto& w = workers[t];
+        w.db = db;
+        w.config = &config;
+        w.first = config.keys * t / config.threads;
+        w.last = config.keys * (t + 1) / config.threads;
+        w.key.resize(config.key_bytes);
+        w.keys.resize(BENCH_GET_MANY * (sizeof(int32_t) + config.key_bytes));
+        w.value.resize(std::max(config.value_bytes, per_call_bytes), 'v');
+        env->PushLocalFrame(4);
+        w.key_buffer = env->NewGlobalRef(env->NewDirectByteBuffer(w.key.data(), w.key.size()));
+        w.keys_buffer = env->NewGlobalRef(env->NewDirectByteBuffer(w.keys.data(), w.keys.size()));
+        w.value_buffer = env->NewGlobalRef(env->NewDirectByteBuffer(w.value.data(), w.value.size()));
+        w.key_array = (jbyteArray) env->NewGlobalRef(env->NewByteArray(config.key_bytes));
+        w.value_array = (jbyteArray) env->NewGlobalRef(env->NewByteArray(config.value_bytes));
+        env->PopLocalFrame(nullptr);
+    }
+
+    const jint kb = config.key_bytes;
+    const jint vb = config.value_bytes;
+    const auto key_buffer = [kb](Worker& w, size_t i) { make_key(i, w.key.data(), kb); };
+    const auto key_array = [](Worker& w, size_t i) { set_key(w, i); };
+    run("put_buffer", workers, 1, key_buffer, [kb, vb](Worker& w, size_t i) {
+        Java_io_pmem_pmemkv_Database_database_1put_1buffer(w.env, nullptr, w.db, kb, w.key_buffer, vb, w.value_buffer);
+        check(w.env, "put_buffer");
+    });
+    run("get_buffer", workers, 1, key_buffer, [kb](Worker& w, size_t i) {
+        Java_io_pmem_pmemkv_Database_database_1get_1buffer(w.env, nullptr, w.db, kb, w.key_buffer,
+                w.value.size(), w.value_buffer);
+        check(w.env, "get_buffer");
+    });
+    run("exists_buffer", workers, 1, key_buffer, [kb](Worker& w, size_t i) {
+        Java_io_pmem_pmemkv_Database_database_1exists_1buffer(w.env, nullptr, w.db, kb, w.key_buffer);
+        check(w.env, "exists_buffer");
+    });
+    run("put_bytes", workers, 1, key_array, [](Worker& w, size_t i) {
+        Java_io_pmem_pmemkv_Database_database_1put_1bytes(w.env, nullptr, w.db, w.key_array, w.value_array);
+        check(w.env, "put_bytes");
+    });
+    run("get_bytes", workers, 1, key_array, [](Worker& w, size_t i) {
+        const auto value = Java_io_pmem_pmemkv_Database_database_1get_1bytes(w.env, nullptr, w.db, w.key_array);
+        check(w.env, "get_bytes");
+        w.env->DeleteLocalRef(value);
+    });
+    run("get_into_bytes", workers, 1, key_array, [](Worker& w, size_t i) {
+        Java_io_pmem_pmemkv_Database_database_1get_1into_1bytes(w.env, nullptr, w.db, w.key_array,
+                w.value_array, 0);
+        check(w.env, "get_into_bytes");
+    });
+    run("exists_bytes", workers, 1, key_array, [](Worker& w, size_t i) {
+        Java_io_pmem_pmemkv_Database_database_1exists_1bytes(w.env, nullptr, w.db, w.key_array);
+        check(w.env, "exists_bytes");
+    });
+    run("get_many_buffer", workers, BENCH_GET_MANY, [kb](Worker& w, size_t i) {
+        // [int32 keybytes][key] per key
+        const auto n = std::min((size_t) BENCH_GET_MANY, w.last - i);
+        for (size_t k = 0; k < n; k++) {
+            const auto entry = w.keys.data() + k * (sizeof(int32_t) + kb);
+            std::memcpy(entry, &kb, sizeof(int32_t));
+            make_key(i + k, entry + sizeof(int32_t), kb);
+        }
+    }, [kb](Worker& w, size_t i) {
+        const auto n = std::min((size_t) BENCH_GET_MANY, w.last - i);
+        Java_io_pmem_pmemkv_Database_database_1get_1many_1buffer(w.env, nullptr, w.db, n,
+                n * (sizeof(int32_t) + kb), w.keys_buffer, w.value.size(), w.value_buffer);
+        check(w.env, "get_many_buffer");
+    });
+    run("count_all", workers, std::max((size_t) 1, config.keys / 100), nullptr, [](Worker& w, size_t i) {
+        Java_io_pmem_pmemkv_Database_database_1count_1all(w.env, nullptr, w.db);
+        check(w.env, "count_all");
+    });
+    run("remove_bytes", workers, 2, key_array, [](Worker& w, size_t i) {
+        Java_io_pmem_pmemkv_Database_database_1remove_1bytes(w.env, nullptr, w.db, w.key_array);
+        check(w.env, "remove_bytes");
+    });
+    run("remove_buffer", workers, 1, key_buffer, [kb](Worker& w, size_t i) {
+        Java_io_pmem_pmemkv_Database_database_1remove_1buffer(w.env, nullptr, w.db, kb, w.key_buffer);
+        check(w.env, "remove_buffer");
+    });
+
+    for (auto& w : workers) {
+        env->DeleteGlobalRef(w.key_buffer);
+        env->DeleteGlobalRef(w.keys_buffer);
+        env->DeleteGlobalRef(w.value_buffer);
+        env->DeleteGlobalRef(w.key_array);
+        env->DeleteGlobalRef(w.value_array);
+    }
+    Java_io_pmem_pmemkv_Database_database_1stop(env, nullptr, db);
+    if (persistent) std::remove(path.c_str());
+    std::cout << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0] << " [--engines=cmap,...] [--persistent=cmap,...] [--dir=/tmp]"
+                  << " [--path=FILE] [--keys=N] [--key_bytes=N,...] [--value_bytes=N,...] [--threads=N,...]"
+                  << std::endl;
+        return 1;
+    }
+    if (getenv("PMEM_IS_PMEM_FORCE") == nullptr)
+        std::cerr << "PMEM_IS_PMEM_FORCE is not set, file-backed pools will be slow" << std::endl;
+
+    JNIEnv* env;
+    JavaVMInitArgs args;
+    args.version = JNI_VERSION_1_6;
+    args.nOptions = 0;
+    args.options = NULL;
+    args.ignoreUnrecognized = JNI_TRUE;
+    if (JNI_CreateJavaVM(&vm, (void**) &env, &args) != JNI_OK) {
+        std::cerr << "Cannot create Java VM" << std::endl;
+        return 1;
+    }
+    // the library is linked, not loaded by System.loadLibrary
+    JNI_OnLoad(vm, nullptr);
+
+    for (const auto& engine : options.engines)
+        for (const auto key_bytes : options.key_bytes)
+            for (const auto value_bytes : options.value_bytes)
+                for (const auto threads : options.threads)
+                    bench(env, options, {engine, options.keys, key_bytes, value_bytes, threads});
+
+    JNI_OnUnload(vm, nullptr);
+    vm->DestroyJavaVM();
+    return 0;
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2019, Intel Corporation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in
+ *       the documentation and/or other materials provided with the
+ *       distribution.
+ *
+ *     * Neither the name of the copyright holder nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Compares the ways of reading a byte[] argument from native code, for the
+ * size classes typical of keys and values: GetByteArrayElements (what the
+ * *_bytes entry points used to do), GetByteArrayRegion into a stack buffer
+ * and GetPrimitiveArrayCritical. The results drive BYTE_ARRAY_STACK_BYTES.
+ */
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <jni.h>
+
+#define STACK_BYTES 65536
+#define ITERATIONS 2000000
+
+static const jsize SIZES[] = {8, 16, 32, 64, 128, 256, 512, 1024, 4096, 16384, 65536};
+
+template<typename F>
+static double measure(F access) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) access();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+}
+
+int main(int argc, char* argv[]) {
+    JavaVM* vm;
+    JNIEnv* env;
+    JavaVMInitArgs args;
+    args.version = JNI_VERSION_1_6;
+    args.nOptions = 0;
+    args.options = NULL;
+    args.ignoreUnrecognized = JNI_TRUE;
+    if (JNI_CreateJavaVM(&vm, (void**) &env, &args) != JNI_OK) {
+        std::cerr << "Cannot create Java VM" << std::endl;
+        return 1;
+    }
+
+    static char stack[STACK_BYTES];
+    volatile char sink = 0;
+    std::cout << std::setw(8) << "bytes" << std::setw(12) << "elements" << std::setw(12) << "region"
+              << std::setw(12) << "critical" << "   (ns/op)" << std::endl;
+    for (const auto size : SIZES) {
+        const auto array = env->NewByteArray(size);
+        const auto elements = measure([&] {
+            const auto data = env->GetByteArrayElements(array, NULL);
+            sink = sink + data[size - 1];
+            env->ReleaseByteArrayElements(array, data, JNI_ABORT);
+        });
+        const auto region = measure([&] {
+            env->GetByteArrayRegion(array, 0, size, (jbyte*) stack);
+            sink = sink + stack[size - 1];
+        });
+        const auto critical = measure([&] {
+            const auto data = (char*) env->GetPrimitiveArrayCritical(array, NULL);
+            sink = sink + data[size - 1];
+            env->ReleasePrimitiveArrayCritical(array, data, JNI_ABORT);
+        });
+        env->DeleteLocalRef(array);
+        std::cout << std::fixed << std::setprecision(1) << std::setw(8) << size << std::setw(12) << elements
+                  << std::setw(12) << region << std::setw(12) << critical << std::endl;
+    }
+
+    vm->DestroyJavaVM();
+    return 0;
+}
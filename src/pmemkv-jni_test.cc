@@ -30,8 +30,16 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include "io_pmem_pmemkv_Database.h"
+// the tests reach the library's internal classes, so it is built in here
+#include "io_pmem_pmemkv_Database.cpp"
 #include "gtest/gtest.h"
+#include <cstdarg>
+#include <random>
+#include <set>
+#include <unistd.h>
+
+#define TEST_ENGINE "vsmap"
+#define TEST_SIZE (64ULL << 20)
 
 int main(int argc, char* argv[]) {
     ::testing::InitGoogleTest(&argc, argv);
@@ -46,3 +54,1590 @@ class KVEmptyTest : public testing::Test {
 
 TEST_F(KVEmptyTest, DoNothingTest) {
 }
+
+/* Directory for the volatile test engine, PMEMKV_TEST_DIR or /dev/shm. */
+static std::string test_dir() {
+    const char* dir = std::getenv("PMEMKV_TEST_DIR");
+    return dir != nullptr ? dir : "/dev/shm";
+}
+
+/*
+ * Just enough of a JNIEnv to call the natives without a JVM: direct
+ * buffers, byte[], long[] and Object[] arrays, strings, boxed ints, batch
+ * callbacks, CompletableFutures, a pending exception and a JavaVM which
+ * gives every attached thread a FakeJni of its own. Objects live until
+ * their FakeJni is destroyed; an exception object is its message string.
+ */
+struct FakeArray : _jbyteArray {
+    std::vector<char> data;
+    size_t width;
+};
+
+struct FakeBuffer : _jobject {
+    char* data;
+    jlong capacity;
+};
+
+struct FakeString : _jstring {
+    std::string value;
+};
+
+struct FakeBox : _jobject {
+    jint value;
+};
+
+/* Completed as "null", the boxed value or "exception: <message>". */
+struct FakeFuture : _jobject {
+    std::mutex lock;
+    std::condition_variable cond;
+    bool done = false;
+    std::string result;
+
+    void complete(const std::string& outcome) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (done) return;
+        result = outcome;
+        done = true;
+        cond.notify_all();
+    }
+
+    std::string wait() {
+        std::unique_lock<std::mutex> guard(lock);
+        if (!cond.wait_for(guard, std::chrono::seconds(10), [this] { return done; })) return "<timeout>";
+        return result;
+    }
+};
+
+/* Receives process(int count, int bytes) calls, as the batch callbacks do. */
+struct FakeCallback : _jobject {
+    std::function<void(jint, jint)> process;
+};
+
+struct FakeJni;
+
+struct FakeVm {
+    JavaVM vm;
+    JNIInvokeInterface_ functions;
+    FakeJni* jni;
+};
+
+struct FakeJni {
+    JNIEnv env;
+    JNINativeInterface_ functions;
+    FakeVm vm;
+    std::list<FakeArray> arrays;
+    std::list<FakeBuffer> buffers;
+    std::list<FakeString> strings;
+    std::list<FakeCallback> callbacks;
+    std::list<FakeBox> boxes;
+    std::list<FakeFuture> futures;
+    _jclass cls;
+    FakeString throwable;
+    bool pending = false;
+    std::string exception;
+
+    FakeJni() {
+        std::memset(&functions, 0, sizeof(functions));
+        env.functions = &functions;
+        std::memset(&vm.functions, 0, sizeof(vm.functions));
+        vm.vm.functions = &vm.functions;
+        vm.jni = this;
+        const auto attach = [](JavaVM*, void** penv, void*) -> jint {
+            *penv = &attached().env;
+            return JNI_OK;
+        };
+        vm.functions.AttachCurrentThread = attach;
+        vm.functions.AttachCurrentThreadAsDaemon = attach;
+        vm.functions.DetachCurrentThread = [](JavaVM*) -> jint { return JNI_OK; };
+        vm.functions.GetEnv = [](JavaVM*, void** penv, jint) -> jint {
+            *penv = &attached().env;
+            return JNI_OK;
+        };
+        functions.GetJavaVM = [](JNIEnv* env, JavaVM** vm) -> jint {
+            *vm = &fake(env)->vm.vm;
+            return JNI_OK;
+        };
+        functions.GetObjectArrayElement = [](JNIEnv*, jobjectArray array, jsize index) -> jobject {
+            jobject element;
+            std::memcpy(&element, ((FakeArray*) array)->data.data() + index * sizeof(jobject), sizeof(jobject));
+            return element;
+        };
+        functions.FindClass = [](JNIEnv* env, const char*) -> jclass { return &fake(env)->cls; };
+        functions.NewGlobalRef = [](JNIEnv*, jobject obj) {
+            if (obj != nullptr) global_refs++;
+            return obj;
+        };
+        functions.DeleteGlobalRef = [](JNIEnv*, jobject obj) {
+            if (obj != nullptr) global_refs--;
+        };
+        functions.NewDirectByteBuffer = [](JNIEnv* env, void* data, jlong capacity) {
+            return fake(env)->buffer((char*) data, capacity);
+        };
+        functions.DeleteLocalRef = [](JNIEnv*, jobject) {};
+        functions.IsInstanceOf = [](JNIEnv*, jobject, jclass) -> jboolean { return JNI_FALSE; };
+        functions.GetObjectClass = [](JNIEnv* env, jobject) -> jclass { return &fake(env)->cls; };
+        functions.GetMethodID = [](JNIEnv*, jclass, const char* name, const char*) { return method(name); };
+        functions.GetStaticMethodID = [](JNIEnv*, jclass, const char* name, const char*) { return method(name); };
+        functions.NewStringUTF = [](JNIEnv* env, const char* value) { return fake(env)->string(value); };
+        // the only objects the natives create are exceptions from a message
+        functions.NewObjectV = [](JNIEnv*, jclass, jmethodID, va_list args) { return va_arg(args, jobject); };
+        // Integer.valueOf and Boolean.valueOf, both promoted to int
+        functions.CallStaticObjectMethodV = [](JNIEnv* env, jclass, jmethodID, va_list args) -> jobject {
+            auto& boxes = fake(env)->boxes;
+            boxes.push_back(FakeBox());
+            boxes.back().value = va_arg(args, jint);
+            return &boxes.back();
+        };
+        // CompletableFuture.complete and completeExceptionally
+        functions.CallBooleanMethodV = [](JNIEnv*, jobject future, jmethodID mid, va_list args) -> jboolean {
+            const auto value = va_arg(args, jobject);
+            std::string outcome;
+            if (*reinterpret_cast<std::string*>(mid) == "completeExceptionally")
+                outcome = "exception: " + static_cast<FakeString*>(value)->value;
+            else
+                outcome = value == nullptr ? "null" : std::to_string(static_cast<FakeBox*>(value)->value);
+            static_cast<FakeFuture*>(future)->complete(outcome);
+            return JNI_TRUE;
+        };
+        functions.CallVoidMethodV = [](JNIEnv*, jobject callback, jmethodID, va_list args) {
+            const auto count = va_arg(args, jint);
+            const auto bytes = va_arg(args, jint);
+            static_cast<FakeCallback*>(callback)->process(count, bytes);
+        };
+        functions.ThrowNew = [](JNIEnv* env, jclass, const char* message) -> jint {
+            fake(env)->pending = true;
+            fake(env)->exception = message;
+            fake(env)->throwable.value = message;
+            return 0;
+        };
+        functions.Throw = [](JNIEnv* env, jthrowable) -> jint {
+            fake(env)->pending = true;
+            return 0;
+        };
+        functions.ExceptionCheck = [](JNIEnv* env) -> jboolean { return fake(env)->pending; };
+        functions.ExceptionOccurred = [](JNIEnv* env) -> jthrowable {
+            return fake(env)->pending ? (jthrowable) (jobject) &fake(env)->throwable : nullptr;
+        };
+        functions.ExceptionClear = [](JNIEnv* env) { fake(env)->pending = false; };
+        functions.GetDirectBufferAddress = [](JNIEnv*, jobject buffer) -> void* {
+            return static_cast<FakeBuffer*>(buffer)->data;
+        };
+        functions.GetDirectBufferCapacity = [](JNIEnv*, jobject buffer) -> jlong {
+            return static_cast<FakeBuffer*>(buffer)->capacity;
+        };
+        functions.GetStringUTFChars = [](JNIEnv*, jstring string, jboolean*) -> const char* {
+            return static_cast<FakeString*>(string)->value.c_str();
+        };
+        functions.ReleaseStringUTFChars = [](JNIEnv*, jstring, const char*) {};
+        functions.GetArrayLength = [](JNIEnv*, jarray array) -> jsize {
+            const auto a = (FakeArray*) array;
+            return a->data.size() / a->width;
+        };
+        functions.NewByteArray = [](JNIEnv* env, jsize length) -> jbyteArray {
+            return fake(env)->array(std::string(length, '\0'));
+        };
+        functions.NewLongArray = [](JNIEnv* env, jsize length) -> jlongArray {
+            return fake(env)->longs(std::vector<jlong>(length));
+        };
+        functions.GetByteArrayRegion = [](JNIEnv*, jbyteArray array, jsize start, jsize length, jbyte* out) {
+            std::memcpy(out, ((FakeArray*) array)->data.data() + start, length);
+        };
+        functions.SetByteArrayRegion = [](JNIEnv*, jbyteArray array, jsize start, jsize length, const jbyte* in) {
+            std::memcpy(((FakeArray*) array)->data.data() + start, in, length);
+        };
+        functions.GetLongArrayRegion = [](JNIEnv*, jlongArray array, jsize start, jsize length, jlong* out) {
+            std::memcpy(out, ((FakeArray*) array)->data.data() + start * sizeof(jlong), length * sizeof(jlong));
+        };
+        functions.SetLongArrayRegion = [](JNIEnv*, jlongArray array, jsize start, jsize length, const jlong* in) {
+            std::memcpy(((FakeArray*) array)->data.data() + start * sizeof(jlong), in, length * sizeof(jlong));
+        };
+    }
+
+    FakeJni(const FakeJni&) = delete;
+    FakeJni& operator=(const FakeJni&) = delete;
+
+    /* Global refs created and not yet deleted, by any FakeJni. */
+    static std::atomic<long> global_refs;
+
+    static FakeJni* fake(JNIEnv* env) {
+        return reinterpret_cast<FakeJni*>(env);
+    }
+
+    /* The FakeJni of a thread attached to the JavaVM. */
+    static FakeJni& attached() {
+        static thread_local FakeJni jni;
+        return jni;
+    }
+
+    /* Method IDs are their interned names. */
+    static jmethodID method(const char* name) {
+        static std::mutex lock;
+        static std::set<std::string> names;
+        std::lock_guard<std::mutex> guard(lock);
+        return reinterpret_cast<jmethodID>(const_cast<std::string*>(&*names.insert(name).first));
+    }
+
+    jobject buffer(char* data, size_t capacity) {
+        buffers.push_back(FakeBuffer());
+        buffers.back().data = data;
+        buffers.back().capacity = capacity;
+        return &buffers.back();
+    }
+
+    jbyteArray array(const std::string& value) {
+        arrays.push_back(FakeArray());
+        arrays.back().data.assign(value.begin(), value.end());
+        arrays.back().width = 1;
+        return &arrays.back();
+    }
+
+    static std::string value(jbyteArray array) {
+        const auto& data = ((FakeArray*) array)->data;
+        return std::string(data.begin(), data.end());
+    }
+
+    jlongArray longs(const std::vector<jlong>& values) {
+        arrays.push_back(FakeArray());
+        arrays.back().data.resize(values.size() * sizeof(jlong));
+        if (!values.empty()) std::memcpy(arrays.back().data.data(), values.data(), arrays.back().data.size());
+        arrays.back().width = sizeof(jlong);
+        return (jlongArray) (jbyteArray) &arrays.back();
+    }
+
+    jobjectArray objects(const std::vector<jobject>& values) {
+        arrays.push_back(FakeArray());
+        arrays.back().data.resize(values.size() * sizeof(jobject));
+        if (!values.empty()) std::memcpy(arrays.back().data.data(), values.data(), arrays.back().data.size());
+        arrays.back().width = sizeof(jobject);
+        return (jobjectArray) (jbyteArray) &arrays.back();
+    }
+
+    static std::vector<jlong> values(jlongArray array) {
+        const auto& data = ((FakeArray*) array)->data;
+        std::vector<jlong> result(data.size() / sizeof(jlong));
+        if (!result.empty()) std::memcpy(result.data(), data.data(), data.size());
+        return result;
+    }
+
+    jstring string(const std::string& value) {
+        strings.push_back(FakeString());
+        strings.back().value = value;
+        return &strings.back();
+    }
+
+    jobject future() {
+        futures.emplace_back();
+        return &futures.back();
+    }
+
+    jobject callback(const std::function<void(jint, jint)>& process) {
+        callbacks.push_back(FakeCallback());
+        callbacks.back().process = process;
+        return &callbacks.back();
+    }
+
+    /* Returns the pending exception message and clears it, or "" if none. */
+    std::string thrown() {
+        if (!pending) return "";
+        pending = false;
+        return exception;
+    }
+};
+
+std::atomic<long> FakeJni::global_refs{0};
+
+const auto CALLBACK_STRING = [](const char* v, size_t vb, void* arg) {
+    ((std::string*) arg)->assign(v, vb);
+};
+
+static std::string numbered_key(int i) {
+    char key[16];
+    snprintf(key, sizeof(key), "k%05d", i);
+    return key;
+}
+
+class DatabaseTest : public testing::Test {
+  public:
+    ~DatabaseTest() {
+        close();
+    }
+
+  protected:
+    FakeJni jni;
+    JNIEnv* env = &jni.env;
+    Database* db = nullptr;
+    Config cfg;
+
+    void open(const char* engine = TEST_ENGINE) {
+        close();
+        cfg.put("path", Config::STRING).string = test_dir();
+        cfg.put("size", Config::UINT64).number = TEST_SIZE;
+        const Config* handle = &cfg;
+        db = (Database*) start_database(env, engine, [handle](ConfigScope scope) { return handle->build(scope); });
+        ASSERT_NE(nullptr, db) << jni.thrown();
+    }
+
+    void option(const char* key, uint64_t value) {
+        cfg.put(key, Config::UINT64).number = value;
+    }
+
+    void option(const char* key, const char* value) {
+        cfg.put(key, Config::STRING).string = value;
+    }
+
+    void close() {
+        if (db != nullptr) Java_io_pmem_pmemkv_Database_database_1stop(env, nullptr, (jlong) db);
+        db = nullptr;
+    }
+
+    void put(const std::string& key, const std::string& value) {
+        ASSERT_EQ(PMEMKV_STATUS_OK, db->put(key.data(), key.size(), value.data(), value.size()));
+    }
+
+    /* The value under 'key', or "<missing>". */
+    std::string get(const std::string& key) {
+        std::string value;
+        const auto status = db->get(key.data(), key.size(), CALLBACK_STRING, &value);
+        return status == PMEMKV_STATUS_OK ? value : "<missing>";
+    }
+};
+
+TEST(ReadCacheTest, HitMissAndInvalidate) {
+    ReadCache cache(1 << 20, 4);
+    std::string value;
+    EXPECT_FALSE(cache.get("a", 1, CALLBACK_STRING, &value));
+    cache.insert("a", 1, "one", 3, cache.version("a", 1));
+    ASSERT_TRUE(cache.get("a", 1, CALLBACK_STRING, &value));
+    EXPECT_EQ("one", value);
+
+    cache.invalidate("a", 1);
+    EXPECT_FALSE(cache.get("a", 1, CALLBACK_STRING, &value));
+
+    // a fill racing with a write must not insert
+    const auto version = cache.version("a", 1);
+    cache.invalidate("a", 1);
+    cache.insert("a", 1, "stale", 5, version);
+    EXPECT_FALSE(cache.get("a", 1, CALLBACK_STRING, &value));
+
+    jlong stats[CACHE_STATS];
+    cache.stats(stats);
+    EXPECT_EQ(1, stats[0]);
+    EXPECT_EQ(3, stats[1]);
+    EXPECT_EQ(0, stats[3]);
+}
+
+TEST(ReadCacheTest, ClockEvictsUnreferencedEntries) {
+    // one shard that holds exactly 8 entries of 1 + 63 + CACHE_ENTRY_OVERHEAD bytes
+    const size_t entry = 1 + 63 + CACHE_ENTRY_OVERHEAD;
+    ReadCache cache(8 * entry, 1);
+    const std::string value(63, 'v');
+    for (char k = '0'; k < '8'; k++) cache.insert(&k, 1, value.data(), value.size(), cache.version(&k, 1));
+
+    std::string out;
+    ASSERT_TRUE(cache.get("0", 1, CALLBACK_STRING, &out));
+    cache.insert("8", 1, value.data(), value.size(), cache.version("8", 1));
+
+    // "0" was referenced and got a second chance, "1" was the next victim
+    EXPECT_TRUE(cache.get("0", 1, CALLBACK_STRING, &out));
+    EXPECT_FALSE(cache.get("1", 1, CALLBACK_STRING, &out));
+    EXPECT_TRUE(cache.get("8", 1, CALLBACK_STRING, &out));
+    jlong stats[CACHE_STATS];
+    cache.stats(stats);
+    EXPECT_EQ(1, stats[2]);
+    EXPECT_EQ(8, stats[3]);
+    EXPECT_EQ((jlong) (8 * entry), stats[4]);
+}
+
+struct ReentrantRead {
+    ReadCache* cache;
+    std::string value;
+    bool inner_hit;
+};
+
+TEST(ReadCacheTest, CallbackMayReenterTheCache) {
+    ReadCache cache(1 << 20, 1);
+    cache.insert("a", 1, "one", 3, cache.version("a", 1));
+    ReentrantRead read = {&cache, "", false};
+    ASSERT_TRUE(cache.get("a", 1, [](const char* v, size_t vb, void* arg) {
+        const auto r = (ReentrantRead*) arg;
+        std::string inner;
+        r->inner_hit = r->cache->get("a", 1, CALLBACK_STRING, &inner);
+        // the entry goes away, but the value handed to us stays valid
+        r->cache->invalidate("a", 1);
+        r->value.assign(v, vb);
+    }, &read));
+    EXPECT_TRUE(read.inner_hit);
+    EXPECT_EQ("one", read.value);
+}
+
+TEST_F(DatabaseTest, CacheIsInvalidatedByPutAndRemove) {
+    option("jni_cache_bytes", 1 << 20);
+    open();
+    put("key", "one");
+    EXPECT_EQ("one", get("key"));
+    EXPECT_EQ("one", get("key"));
+    put("key", "two");
+    EXPECT_EQ("two", get("key"));
+    ASSERT_EQ(PMEMKV_STATUS_OK, db->remove("key", 3));
+    EXPECT_EQ("<missing>", get("key"));
+
+    jlong stats[CACHE_STATS];
+    db->cache->stats(stats);
+    EXPECT_EQ(1, stats[0]);
+    EXPECT_EQ(0, stats[3]);
+}
+
+static std::string sidecar_path() {
+    return test_dir() + "/pmemkv-jni_test.bloom";
+}
+
+/* Overwrites the uint64 at 'index' of the sidecar. */
+static void patch_sidecar(size_t index, uint64_t value) {
+    FILE* file = fopen(sidecar_path().c_str(), "r+b");
+    ASSERT_NE(nullptr, file);
+    ASSERT_EQ(0, fseek(file, index * sizeof(uint64_t), SEEK_SET));
+    ASSERT_EQ(1u, fwrite(&value, sizeof(value), 1, file));
+    fclose(file);
+}
+
+TEST(BloomFilterTest, SidecarRoundTrip) {
+    BloomFilter filter(100, 10);
+    filter.insert("key", 3);
+    ASSERT_TRUE(filter.save(sidecar_path(), 1));
+    std::unique_ptr<BloomFilter> loaded(BloomFilter::load(sidecar_path(), 1));
+    std::remove(sidecar_path().c_str());
+    ASSERT_NE(nullptr, loaded);
+    EXPECT_TRUE(loaded->may_contain("key", 3));
+    EXPECT_EQ(filter.bits(), loaded->bits());
+    EXPECT_EQ(filter.bits_set(), loaded->bits_set());
+}
+
+TEST(BloomFilterTest, SidecarWithBadBlockCountIsRejected) {
+    BloomFilter filter(100, 10);
+    ASSERT_TRUE(filter.save(sidecar_path(), 1));
+    // large enough to overflow the word count
+    patch_sidecar(1, UINT64_MAX / 2);
+    EXPECT_EQ(nullptr, BloomFilter::load(sidecar_path(), 1));
+    patch_sidecar(1, filter.bits() / BLOOM_BLOCK_BITS + 1);
+    EXPECT_EQ(nullptr, BloomFilter::load(sidecar_path(), 1));
+    patch_sidecar(1, filter.bits() / BLOOM_BLOCK_BITS);
+    EXPECT_EQ(nullptr, BloomFilter::load(sidecar_path(), 2));
+    std::unique_ptr<BloomFilter> loaded(BloomFilter::load(sidecar_path(), 1));
+    EXPECT_NE(nullptr, loaded);
+    std::remove(sidecar_path().c_str());
+}
+
+TEST(BloomFilterTest, TruncatedSidecarIsRejected) {
+    BloomFilter filter(100, 10);
+    ASSERT_TRUE(filter.save(sidecar_path(), 1));
+    ASSERT_EQ(0, truncate(sidecar_path().c_str(), 4 * sizeof(uint64_t) + 8));
+    EXPECT_EQ(nullptr, BloomFilter::load(sidecar_path(), 1));
+    std::remove(sidecar_path().c_str());
+}
+
+static int engine_call() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    return PMEMKV_STATUS_OK;
+}
+
+static int wrapped_engine_call() {
+    const auto status = timed(engine_call);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    return status;
+}
+
+TEST(OpTimerTest, NestedTimersKeepTheOuterTotals) {
+    OpTimer outer(STATS_GET_BYTES);
+    stats_bytes(10);
+    {
+        OpTimer inner(STATS_PUT_BYTES);
+        stats_bytes(5);
+        EXPECT_EQ(5u, thread_op_bytes);
+    }
+    EXPECT_EQ(15u, thread_op_bytes);
+}
+
+TEST(OpTimerTest, OnlyTheInnermostEngineCallIsTimed) {
+    OpTimer timer(STATS_GET_BYTES);
+    timed(wrapped_engine_call);
+    EXPECT_GE(thread_engine_ns, 2000000u);
+    EXPECT_LT(thread_engine_ns, 20000000u);
+}
+
+/* Collects "key" or "key=value" entries visited by a scan. */
+struct Visited {
+    bool values;
+    std::vector<std::string> entries;
+};
+
+const auto CALLBACK_VISIT = [](const char* k, size_t kb, const char* v, size_t vb, void* arg) -> int {
+    const auto visited = (Visited*) arg;
+    visited->entries.push_back(visited->values ? std::string(k, kb) + "=" + std::string(v, vb) : std::string(k, kb));
+    return 0;
+};
+
+TEST_F(DatabaseTest, PrefixScans) {
+    option("jni_compression", "lz");
+    option("jni_compression_min_bytes", 1);
+    open();
+    const std::string ff("\xFF", 1);
+    for (const auto& key : {std::string("a"), std::string("ab"), std::string("abc"), std::string("abd"),
+            std::string("ac"), std::string("b"), ff, ff + "x"})
+        put(key, std::string(100, 'v') + key);
+
+    Visited keys = {false, {}};
+    ASSERT_EQ(PMEMKV_STATUS_OK, scan_prefix(db, "ab", 2, true, CALLBACK_VISIT, &keys));
+    EXPECT_EQ((std::vector<std::string>{"ab", "abc", "abd"}), keys.entries);
+    size_t count;
+    ASSERT_EQ(PMEMKV_STATUS_OK, count_prefix(db, "ab", 2, &count));
+    EXPECT_EQ(3u, count);
+
+    // key-only scans never decode a value
+    jlong before[CODEC_STATS], after[CODEC_STATS];
+    db->codec->stats(before);
+    keys.entries.clear();
+    ASSERT_EQ(PMEMKV_STATUS_OK, scan_prefix(db, ff.data(), 1, true, CALLBACK_VISIT, &keys));
+    EXPECT_EQ((std::vector<std::string>{ff, ff + "x"}), keys.entries);
+    db->codec->stats(after);
+    EXPECT_EQ(before[5], after[5]);
+
+    Visited all = {true, {}};
+    ASSERT_EQ(PMEMKV_STATUS_OK, scan_prefix(db, "abc", 3, false, CALLBACK_VISIT, &all));
+    EXPECT_EQ((std::vector<std::string>{"abc=" + std::string(100, 'v') + "abc"}), all.entries);
+    ASSERT_EQ(PMEMKV_STATUS_OK, count_prefix(db, "", 0, &count));
+    EXPECT_EQ(8u, count);
+    ASSERT_EQ(PMEMKV_STATUS_OK, count_prefix(db, "zz", 2, &count));
+    EXPECT_EQ(0u, count);
+}
+
+TEST(ConfigTest, StripJniKeys) {
+    EXPECT_EQ("{}", strip_config_keys("{}", CONFIG_ENGINE));
+    EXPECT_EQ("{}", strip_config_keys(" { \"jni_shards\" : 2 } ", CONFIG_ENGINE));
+    EXPECT_EQ("{\"path\":\"/a,b}\",\"size\":1}",
+            strip_config_keys("{\"jni_cache_bytes\":1,\"path\":\"/a,b}\",\"jni_x\":{\"y\":[1,{}]},\"size\":1}",
+                    CONFIG_ENGINE));
+    EXPECT_EQ("{\"a\":\"q\\\"jni_\",\"b\":[1,2]}",
+            strip_config_keys("{\"a\":\"q\\\"jni_\",\"jni_c\":\"\\\\\",\"b\":[1,2]}", CONFIG_ENGINE));
+    EXPECT_EQ("{\"jni_", strip_config_keys("{\"jni_", CONFIG_ENGINE));
+    EXPECT_EQ("[1]", strip_config_keys("[1]", CONFIG_ENGINE));
+    EXPECT_EQ("{\"jni_shards\":2}", strip_config_keys("{\"jni_shards\":2}", CONFIG_ALL));
+}
+
+TEST(ConfigTest, ShardConfigLeavesOutPath) {
+    EXPECT_EQ("{\"size\":1,\"paths\":\"x\"}",
+            strip_config_keys("{\"path\":\"/p\",\"size\":1,\"jni_shards\":2,\"paths\":\"x\"}", CONFIG_SHARD));
+}
+
+TEST(ConfigTest, EngineConfigLeavesOutJniKeys) {
+    Config config;
+    config.put("path", Config::STRING).string = "/p";
+    config.put("jni_shards", Config::UINT64).number = 2;
+    const char* path = nullptr;
+    uint64_t shards = 0;
+
+    auto cfg = config.build(CONFIG_ALL);
+    ASSERT_NE(nullptr, cfg);
+    EXPECT_EQ(PMEMKV_STATUS_OK, pmemkv_config_get_uint64(cfg, "jni_shards", &shards));
+    pmemkv_config_delete(cfg);
+
+    cfg = config.build(CONFIG_ENGINE);
+    ASSERT_NE(nullptr, cfg);
+    EXPECT_EQ(PMEMKV_STATUS_OK, pmemkv_config_get_string(cfg, "path", &path));
+    EXPECT_EQ(PMEMKV_STATUS_NOT_FOUND, pmemkv_config_get_uint64(cfg, "jni_shards", &shards));
+    pmemkv_config_delete(cfg);
+
+    cfg = config.build(CONFIG_SHARD);
+    ASSERT_NE(nullptr, cfg);
+    EXPECT_EQ(PMEMKV_STATUS_NOT_FOUND, pmemkv_config_get_string(cfg, "path", &path));
+    pmemkv_config_delete(cfg);
+}
+
+TEST_F(DatabaseTest, ShardsOpenDistinctPools) {
+    option("jni_shards", 2);
+    open();
+    ASSERT_EQ(2u, db->shards.size());
+    EXPECT_NE(db->shards[0], db->shards[1]);
+    for (int i = 0; i < 100; i++) put(numbered_key(i), "v");
+    size_t first = 0, second = 0;
+    ASSERT_EQ(PMEMKV_STATUS_OK, pmemkv_count_all(db->shards[0], &first));
+    ASSERT_EQ(PMEMKV_STATUS_OK, pmemkv_count_all(db->shards[1], &second));
+    EXPECT_GT(first, 0u);
+    EXPECT_GT(second, 0u);
+    EXPECT_EQ(100u, first + second);
+    for (int i = 0; i < 100; i++) EXPECT_EQ("v", get(numbered_key(i)));
+}
+
+TEST_F(DatabaseTest, StartFromJson) {
+    const auto json = "{\"path\":\"" + test_dir() + "\",\"size\":" + std::to_string(TEST_SIZE) +
+            ",\"jni_cache_bytes\":65536}";
+    db = (Database*) Java_io_pmem_pmemkv_Database_database_1start(env, nullptr, jni.string(TEST_ENGINE),
+            jni.string(json));
+    ASSERT_NE(nullptr, db) << jni.thrown();
+    EXPECT_NE(nullptr, db->cache);
+    put("key", "value");
+    EXPECT_EQ("value", get("key"));
+}
+
+class SnapshotTest : public DatabaseTest {
+  public:
+    ~SnapshotTest() {
+        std::remove(path.c_str());
+    }
+
+  protected:
+    const std::string path = test_dir() + "/pmemkv-jni_test.snapshot";
+
+    void SetUp() override {
+        open();
+        for (int i = 0; i < 100; i++) put("key" + std::to_string(i), "value" + std::to_string(i));
+        ASSERT_EQ(100, Java_io_pmem_pmemkv_Database_database_1export_1snapshot(env, nullptr, (jlong) db,
+                jni.string(path), nullptr, nullptr));
+        ASSERT_EQ("", jni.thrown());
+        for (int i = 0; i < 100; i++) {
+            const auto key = "key" + std::to_string(i);
+            ASSERT_EQ(PMEMKV_STATUS_OK, db->remove(key.data(), key.size()));
+        }
+    }
+
+    jlong import() {
+        return Java_io_pmem_pmemkv_Database_database_1import_1snapshot(env, nullptr, (jlong) db, jni.string(path));
+    }
+
+    void patch(long offset, const std::string& bytes) {
+        FILE* file = fopen(path.c_str(), "r+b");
+        ASSERT_NE(nullptr, file);
+        ASSERT_EQ(0, fseek(file, offset, SEEK_SET));
+        ASSERT_EQ(1u, fwrite(bytes.data(), bytes.size(), 1, file));
+        fclose(file);
+    }
+};
+
+// the first block header follows the 16-byte file header
+#define FIRST_BLOCK 16
+#define FIRST_PAYLOAD (FIRST_BLOCK + SNAPSHOT_BLOCK_HEADER_BYTES)
+
+TEST_F(SnapshotTest, RoundTrip) {
+    EXPECT_EQ(100, import());
+    EXPECT_EQ("", jni.thrown());
+    EXPECT_EQ("value42", get("key42"));
+    EXPECT_EQ(100, db->snapshot_progress.load());
+}
+
+TEST_F(SnapshotTest, CorruptedPayloadIsRejected) {
+    patch(FIRST_PAYLOAD + 8, "X");
+    EXPECT_EQ(0, import());
+    EXPECT_EQ("Corrupted snapshot file", jni.thrown());
+    EXPECT_EQ("<missing>", get("key0"));
+}
+
+TEST_F(SnapshotTest, TruncatedFileIsRejected) {
+    ASSERT_EQ(0, truncate(path.c_str(), FIRST_PAYLOAD + 100));
+    EXPECT_EQ(0, import());
+    EXPECT_EQ("Corrupted snapshot file", jni.thrown());
+}
+
+TEST_F(SnapshotTest, HugePayloadLengthIsRejected) {
+    char length[4];
+    store_le32(length, UINT32_MAX);
+    patch(FIRST_BLOCK, std::string(length, sizeof(length)));
+    EXPECT_EQ(0, import());
+    EXPECT_EQ("Corrupted snapshot file", jni.thrown());
+}
+
+TEST_F(SnapshotTest, OversizedMultiRecordBlockIsRejected) {
+    // shrink the declared block size below the first block's payload
+    char blockbytes[4];
+    store_le32(blockbytes, 16);
+    patch(12, std::string(blockbytes, sizeof(blockbytes)));
+    EXPECT_EQ(0, import());
+    EXPECT_EQ("Corrupted snapshot file", jni.thrown());
+}
+
+TEST_F(SnapshotTest, MissingFileIsReported) {
+    std::remove(path.c_str());
+    EXPECT_EQ(0, import());
+    EXPECT_EQ("Cannot open snapshot file", jni.thrown());
+}
+
+static std::string lz_round_trip(const std::string& value) {
+    std::vector<char> compressed(value.size() + 16), decompressed(value.size());
+    const auto bytes = lz_compress(value.data(), value.size(), compressed.data(), compressed.size());
+    if (bytes == 0) return "<incompressible>";
+    if (!lz_decompress(compressed.data(), bytes, decompressed.data(), value.size())) return "<corrupt>";
+    return std::string(decompressed.begin(), decompressed.end());
+}
+
+TEST(LzTest, RoundTrip) {
+    std::string repetitive;
+    for (int i = 0; i < 1000; i++) repetitive += "{\"id\":" + std::to_string(i % 37) + ",\"name\":\"pmemkv\"}";
+    EXPECT_EQ(repetitive, lz_round_trip(repetitive));
+    EXPECT_EQ(std::string(100000, 'a'), lz_round_trip(std::string(100000, 'a')));
+
+    std::mt19937 random(42);
+    for (int i = 0; i < 200; i++) {
+        std::string value(random() % 2000 + 1, '\0');
+        // a small alphabet, so that some matches are found
+        for (auto& c : value) c = (char) ('a' + random() % (i % 4 == 0 ? 255 : 4));
+        const auto result = lz_round_trip(value);
+        if (result != "<incompressible>") {
+            EXPECT_EQ(value, result);
+        }
+    }
+}
+
+TEST(LzTest, CorruptInputIsRejectedSafely) {
+    std::string value;
+    for (int i = 0; i < 200; i++) value += "pmemkv-jni " + std::to_string(i);
+    std::vector<char> compressed(value.size());
+    const auto bytes = lz_compress(value.data(), value.size(), compressed.data(), compressed.size());
+    ASSERT_GT(bytes, 0u);
+    std::vector<char> out(value.size());
+    EXPECT_FALSE(lz_decompress(compressed.data(), bytes - 1, out.data(), out.size()));
+    EXPECT_FALSE(lz_decompress(compressed.data(), bytes, out.data(), out.size() - 1));
+
+    // flipped bits either fail or decode to something, never past 'out'
+    std::mt19937 random(7);
+    for (int i = 0; i < 2000; i++) {
+        auto corrupt = compressed;
+        corrupt[random() % bytes] ^= (char) (1 << (random() % 8));
+        lz_decompress(corrupt.data(), bytes, out.data(), out.size());
+    }
+}
+
+TEST(CodecTest, EncodeDecode) {
+    Codec codec(16);
+    const std::string small = "tiny", large(1000, 'x');
+    std::string decoded;
+    const auto store = [&](const std::string& value) {
+        const auto& stored = codec.encode(value.data(), value.size());
+        return std::string(stored.begin(), stored.end());
+    };
+    const auto decode = [&](const std::string& stored) {
+        decoded = "<not called>";
+        return codec.decode(stored.data(), stored.size(),
+                [&](const char* v, size_t vb) { decoded.assign(v, vb); });
+    };
+
+    const auto raw = store(small);
+    EXPECT_EQ(CODEC_RAW, raw[0]);
+    ASSERT_TRUE(decode(raw));
+    EXPECT_EQ(small, decoded);
+
+    const auto lz = store(large);
+    EXPECT_EQ(CODEC_LZ, lz[0]);
+    EXPECT_LT(lz.size(), large.size());
+    ASSERT_TRUE(decode(lz));
+    EXPECT_EQ(large, decoded);
+
+    jlong stats[CODEC_STATS];
+    codec.stats(stats);
+    EXPECT_EQ(1, stats[0]);
+    EXPECT_EQ(1, stats[1]);
+    EXPECT_EQ((jlong) (small.size() + large.size()), stats[2]);
+    EXPECT_EQ((jlong) (raw.size() + lz.size()), stats[3]);
+}
+
+TEST(CodecTest, CorruptValuesAreRejected) {
+    Codec codec(16);
+    const std::string large(1000, 'x');
+    const auto& encoded = codec.encode(large.data(), large.size());
+    const std::string lz(encoded.begin(), encoded.end());
+    const auto rejects = [&](const std::string& stored) {
+        return !codec.decode(stored.data(), stored.size(), [](const char*, size_t) { FAIL(); });
+    };
+
+    EXPECT_TRUE(rejects(""));
+    EXPECT_TRUE(rejects(std::string(1, '\x7F') + "value"));
+    EXPECT_TRUE(rejects(lz.substr(0, 3)));
+    EXPECT_TRUE(rejects(lz.substr(0, lz.size() / 2)));
+    // an uncompressed size no LZ block of this length could expand to
+    auto huge = lz;
+    store_le32(&huge[CODEC_HEADER_BYTES], UINT32_MAX);
+    EXPECT_TRUE(rejects(huge));
+}
+
+TEST_F(DatabaseTest, CompressedValuesAreDecodedOnRead) {
+    option("jni_compression", "lz");
+    open();
+    const std::string value(1000, 'z');
+    put("key", value);
+    EXPECT_EQ(value, get("key"));
+
+    std::string stored;
+    ASSERT_EQ(PMEMKV_STATUS_OK, pmemkv_get(db->shard("key", 3), "key", 3, CALLBACK_STRING, &stored));
+    EXPECT_EQ(CODEC_LZ, stored[0]);
+    EXPECT_LT(stored.size(), value.size());
+
+    // a corrupt stored value is reported, not handed out
+    ASSERT_EQ(PMEMKV_STATUS_OK, pmemkv_put(db->shard("bad", 3), "bad", 3, "\x7F", 1));
+    std::string result;
+    EXPECT_NE(PMEMKV_STATUS_OK, db->get("bad", 3, CALLBACK_STRING, &result));
+}
+
+TEST_F(DatabaseTest, SplitRangeBalancesPartitions) {
+    open();
+    for (int i = 0; i < 1000; i++) put(numbered_key(i), "v");
+    const std::string k1 = numbered_key(0), k2 = numbered_key(999);
+
+    const auto splits = split_range(db, k1.data(), k1.size(), k2.data(), k2.size(), 4);
+    ASSERT_EQ(3u, splits.size());
+    std::string lower = k1;
+    size_t total = 0;
+    for (size_t i = 0; i <= splits.size(); i++) {
+        const auto& upper = i < splits.size() ? splits[i] : k2;
+        ASSERT_LT(compare_keys(lower.data(), lower.size(), upper.data(), upper.size()), 0);
+        size_t count = 0;
+        ASSERT_EQ(PMEMKV_STATUS_OK, kv_count_between(db, lower.data(), lower.size(), upper.data(), upper.size(), &count));
+        // within the bisection tolerance of a quarter of the 998 keys in between
+        EXPECT_NEAR(250.0, (double) count + (i > 0), 70.0) << "partition " << i;
+        total += count + (i > 0 && get(lower) != "<missing>");
+        lower = upper;
+    }
+    EXPECT_EQ(998u, total);
+
+    EXPECT_TRUE(split_range(db, k1.data(), k1.size(), k2.data(), k2.size(), 1).empty());
+}
+
+TEST_F(DatabaseTest, SplitRangeNeedsDistinctPrefixes) {
+    open();
+    // the keys only differ past the bytes that bisection looks at
+    const std::string common(PARALLEL_SPLIT_BYTES + 2, 'p');
+    for (int i = 0; i < 100; i++) put(common + numbered_key(i), "v");
+    const std::string k1 = "a", k2 = "z";
+    const auto splits = split_range(db, k1.data(), k1.size(), k2.data(), k2.size(), 4);
+    EXPECT_LT(splits.size(), 3u);
+    // so one partition gets all of them
+    size_t largest = 0;
+    std::string lower = k1;
+    for (size_t i = 0; i <= splits.size(); i++) {
+        const auto& upper = i < splits.size() ? splits[i] : k2;
+        size_t count = 0;
+        ASSERT_EQ(PMEMKV_STATUS_OK, kv_count_between(db, lower.data(), lower.size(), upper.data(), upper.size(), &count));
+        largest = std::max(largest, count);
+        lower = upper;
+    }
+    EXPECT_EQ(100u, largest);
+}
+
+class CursorTest : public DatabaseTest {
+  protected:
+    std::vector<char> batch = std::vector<char>(4096);
+    jlong cursor = 0;
+
+    void SetUp() override {
+        open();
+        for (int i = 0; i < 25; i++) put(numbered_key(i), "value" + std::to_string(i));
+    }
+
+    void TearDown() override {
+        if (cursor != 0) Java_io_pmem_pmemkv_Database_database_1cursor_1close(env, nullptr, cursor);
+    }
+
+    void open_cursor(const char* start, bool inclusive, const char* end) {
+        cursor = Java_io_pmem_pmemkv_Database_database_1cursor_1open(env, nullptr, (jlong) db,
+                start != nullptr ? jni.array(start) : nullptr, inclusive, end != nullptr ? jni.array(end) : nullptr);
+    }
+
+    /* Returns the keys of the next page. */
+    std::vector<std::string> next(jint count, size_t batchbytes = 4096) {
+        const auto records = Java_io_pmem_pmemkv_Database_database_1cursor_1next(env, nullptr, cursor, count,
+                batchbytes, jni.buffer(batch.data(), batch.size()));
+        std::vector<std::string> keys;
+        const char* record = batch.data();
+        for (jint i = 0; i < records; i++) {
+            const auto keybytes = read_int32(record);
+            const auto valuebytes = read_int32(record + sizeof(int32_t));
+            keys.emplace_back(record + 2 * sizeof(int32_t), keybytes);
+            record += 2 * sizeof(int32_t) + keybytes + valuebytes;
+        }
+        return keys;
+    }
+
+    std::string token() {
+        const auto key = Java_io_pmem_pmemkv_Database_database_1cursor_1key(env, nullptr, cursor);
+        return key == nullptr ? "<none>" : FakeJni::value(key);
+    }
+};
+
+TEST_F(CursorTest, PagesThroughTheWholeRange) {
+    open_cursor(nullptr, false, nullptr);
+    EXPECT_EQ("<none>", token());
+    std::vector<std::string> keys;
+    for (size_t page : {10u, 10u, 5u}) {
+        const auto result = next(10);
+        ASSERT_EQ(page, result.size());
+        keys.insert(keys.end(), result.begin(), result.end());
+        EXPECT_EQ(keys.back(), token());
+    }
+    EXPECT_TRUE(next(10).empty());
+    ASSERT_EQ(25u, keys.size());
+    for (int i = 0; i < 25; i++) EXPECT_EQ(numbered_key(i), keys[i]);
+}
+
+TEST_F(CursorTest, BoundsAndContinuationToken) {
+    const auto start = numbered_key(5), end = numbered_key(9);
+    open_cursor(start.c_str(), true, end.c_str());
+    EXPECT_EQ((std::vector<std::string>{numbered_key(5), numbered_key(6)}), next(2));
+    const auto resume = token();
+    Java_io_pmem_pmemkv_Database_database_1cursor_1close(env, nullptr, cursor);
+
+    // a new cursor opened on the token, not inclusive, continues after it
+    open_cursor(resume.c_str(), false, end.c_str());
+    EXPECT_EQ((std::vector<std::string>{numbered_key(7), numbered_key(8)}), next(10));
+    EXPECT_TRUE(next(10).empty());
+}
+
+TEST_F(CursorTest, StopsWhenTheBufferIsFull) {
+    open_cursor(nullptr, false, nullptr);
+    // each record is 8 + 6 + 6 or 7 bytes
+    EXPECT_EQ(2u, next(10, 45).size());
+    EXPECT_EQ(numbered_key(1), token());
+    EXPECT_TRUE(next(10, 10).empty());
+    EXPECT_EQ("ByteBuffer is too small", jni.thrown());
+    EXPECT_EQ(numbered_key(2), next(1).at(0));
+}
+
+TEST_F(CursorTest, InvalidBuffersAreRejected) {
+    open_cursor(nullptr, false, nullptr);
+    EXPECT_TRUE(next(10, batch.size() + 1).empty());
+    EXPECT_EQ("ByteBuffer is too small", jni.thrown());
+    EXPECT_TRUE(next(10, (size_t) -1).empty());
+    EXPECT_EQ("Invalid ByteBuffer", jni.thrown());
+    EXPECT_EQ(0, Java_io_pmem_pmemkv_Database_database_1cursor_1next(env, nullptr, cursor, 10, 16,
+            jni.buffer(nullptr, -1)));
+    EXPECT_EQ("Invalid ByteBuffer", jni.thrown());
+    // the cursor has not moved
+    EXPECT_EQ(numbered_key(0), next(1).at(0));
+}
+
+#define RMW_THREADS 8
+#define RMW_ROUNDS 500
+
+class AtomicOpsTest : public DatabaseTest {
+  protected:
+    void SetUp() override {
+        option("jni_atomic_ops", 1);
+        open();
+    }
+
+    template <typename F>
+    static void run_threads(F body) {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < RMW_THREADS; t++) threads.emplace_back(body, t);
+        for (auto& thread : threads) thread.join();
+    }
+
+    jlong value(const std::string& key) {
+        ContextGetLong cxt = {0, false, false};
+        EXPECT_EQ(PMEMKV_STATUS_OK, db->get(key.data(), key.size(), CALLBACK_GET_LONG, &cxt));
+        EXPECT_FALSE(cxt.malformed);
+        return cxt.value;
+    }
+};
+
+TEST_F(DatabaseTest, AtomicOpsNeedTheSetting) {
+    open();
+    EXPECT_EQ(nullptr, db->stripes);
+    EXPECT_EQ(0, Java_io_pmem_pmemkv_Database_database_1increment_1long(env, nullptr, (jlong) db, 1, 1));
+    EXPECT_EQ("Atomic operations are not enabled, open with jni_atomic_ops", jni.thrown());
+    EXPECT_FALSE(Java_io_pmem_pmemkv_Database_database_1put_1if_1absent_1long(env, nullptr, (jlong) db, 1, 1));
+    EXPECT_NE("", jni.thrown());
+}
+
+TEST_F(AtomicOpsTest, IncrementAndCompareAndSetNatives) {
+    const auto pointer = (jlong) db;
+    EXPECT_EQ(5, Java_io_pmem_pmemkv_Database_database_1increment_1long(env, nullptr, pointer, 7, 5));
+    EXPECT_EQ(3, Java_io_pmem_pmemkv_Database_database_1increment_1long(env, nullptr, pointer, 7, -2));
+    EXPECT_TRUE(Java_io_pmem_pmemkv_Database_database_1compare_1and_1set_1long(env, nullptr, pointer, 7, 3, 10));
+    EXPECT_FALSE(Java_io_pmem_pmemkv_Database_database_1compare_1and_1set_1long(env, nullptr, pointer, 7, 3, 11));
+    EXPECT_EQ(10, Java_io_pmem_pmemkv_Database_database_1get_1long(env, nullptr, pointer, 7, -1));
+    EXPECT_FALSE(Java_io_pmem_pmemkv_Database_database_1put_1if_1absent_1long(env, nullptr, pointer, 7, 1));
+    EXPECT_TRUE(Java_io_pmem_pmemkv_Database_database_1put_1if_1absent_1long(env, nullptr, pointer, 8, 1));
+    EXPECT_TRUE(Java_io_pmem_pmemkv_Database_database_1compare_1and_1set_1bytes(env, nullptr, pointer,
+            jni.array("k"), nullptr, jni.array("a")));
+    EXPECT_TRUE(Java_io_pmem_pmemkv_Database_database_1compare_1and_1set_1bytes(env, nullptr, pointer,
+            jni.array("k"), jni.array("a"), jni.array("b")));
+    EXPECT_FALSE(Java_io_pmem_pmemkv_Database_database_1compare_1and_1set_1bytes(env, nullptr, pointer,
+            jni.array("k"), jni.array("a"), jni.array("c")));
+    EXPECT_EQ("b", get("k"));
+    EXPECT_EQ("", jni.thrown());
+}
+
+TEST_F(AtomicOpsTest, ConcurrentIncrementsAreNotLost) {
+    run_threads([this](int) {
+        for (int i = 0; i < RMW_ROUNDS; i++) {
+            ContextGetLong cxt;
+            ASSERT_EQ(PMEMKV_STATUS_OK, increment(db, "counter", 7, 1, &cxt));
+        }
+    });
+    EXPECT_EQ(RMW_THREADS * RMW_ROUNDS, value("counter"));
+}
+
+TEST_F(AtomicOpsTest, ConcurrentCompareAndSetLoops) {
+    char zero[LONG_BYTES];
+    encode_long(zero, 0);
+    put("counter", std::string(zero, LONG_BYTES));
+    run_threads([&](int) {
+        for (int i = 0; i < RMW_ROUNDS; i++) {
+            bool swapped = false;
+            while (!swapped) {
+                ContextGetLong cxt = {0, false, false};
+                ASSERT_EQ(PMEMKV_STATUS_OK, db->get("counter", 7, CALLBACK_GET_LONG, &cxt));
+                char expected[LONG_BYTES], next[LONG_BYTES];
+                encode_long(expected, (uint64_t) cxt.value);
+                encode_long(next, (uint64_t) cxt.value + 1);
+                const auto status = compare_and_set(db, "counter", 7, expected, LONG_BYTES, next, LONG_BYTES, &swapped);
+                ASSERT_FALSE(compare_and_set_failed(status));
+            }
+        }
+    });
+    EXPECT_EQ(RMW_THREADS * RMW_ROUNDS, value("counter"));
+}
+
+TEST_F(AtomicOpsTest, PutIfAbsentHasOneWinner) {
+    std::atomic<int> wins[RMW_ROUNDS];
+    for (auto& w : wins) w = 0;
+    run_threads([&](int t) {
+        const auto value = std::to_string(t);
+        for (int i = 0; i < RMW_ROUNDS; i++) {
+            const auto key = numbered_key(i);
+            bool swapped;
+            ASSERT_FALSE(compare_and_set_failed(compare_and_set(db, key.data(), key.size(), nullptr, 0,
+                    value.data(), value.size(), &swapped)));
+            if (swapped) wins[i]++;
+        }
+    });
+    for (int i = 0; i < RMW_ROUNDS; i++) EXPECT_EQ(1, wins[i].load()) << numbered_key(i);
+}
+
+/* Packs records for the batch natives, in native byte order. */
+struct Batch {
+    std::string bytes;
+
+    Batch& int32(int32_t value) {
+        char b[sizeof(int32_t)];
+        write_int32(b, value);
+        bytes.append(b, sizeof(b));
+        return *this;
+    }
+
+    Batch& key(const std::string& key) {
+        int32(key.size());
+        bytes += key;
+        return *this;
+    }
+
+    Batch& put(const std::string& key, const std::string& value) {
+        bytes += (char) WRITE_BATCH_PUT;
+        int32(key.size()).int32(value.size());
+        bytes += key + value;
+        return *this;
+    }
+
+    Batch& remove(const std::string& key) {
+        bytes += (char) WRITE_BATCH_REMOVE;
+        return this->key(key);
+    }
+
+    jobject buffer(FakeJni& jni) {
+        return jni.buffer(&bytes[0], bytes.size());
+    }
+};
+
+TEST_F(DatabaseTest, WriteBatchAppliesEveryOperation) {
+    open();
+    put("gone", "v");
+    Batch batch;
+    batch.put("a", "1").put("b", "").remove("gone").remove("never");
+    const auto statuses = Java_io_pmem_pmemkv_Database_database_1write_1batch(env, nullptr, (jlong) db, 4,
+            batch.bytes.size(), batch.buffer(jni));
+    ASSERT_NE(nullptr, statuses) << jni.thrown();
+    EXPECT_EQ(std::string({PMEMKV_STATUS_OK, PMEMKV_STATUS_OK, PMEMKV_STATUS_OK, PMEMKV_STATUS_NOT_FOUND}),
+            FakeJni::value(statuses));
+    EXPECT_EQ("1", get("a"));
+    EXPECT_EQ("", get("b"));
+    EXPECT_EQ("<missing>", get("gone"));
+}
+
+TEST_F(DatabaseTest, TruncatedWriteBatchIsRejected) {
+    open();
+    Batch batch;
+    batch.put("a", "1").put("b", "2");
+    const jint truncated = batch.bytes.size() - 1;
+    EXPECT_EQ(nullptr, Java_io_pmem_pmemkv_Database_database_1write_1batch(env, nullptr, (jlong) db, 2,
+            truncated, batch.buffer(jni)));
+    EXPECT_EQ("Malformed write batch", jni.thrown());
+    // records before the malformed one are applied
+    EXPECT_EQ("1", get("a"));
+    EXPECT_EQ("<missing>", get("b"));
+
+    // more bytes than the buffer holds, or more records than could fit
+    EXPECT_EQ(nullptr, Java_io_pmem_pmemkv_Database_database_1write_1batch(env, nullptr, (jlong) db, 2,
+            batch.bytes.size() + 1, batch.buffer(jni)));
+    EXPECT_EQ("ByteBuffer is too small", jni.thrown());
+    EXPECT_EQ(nullptr, Java_io_pmem_pmemkv_Database_database_1write_1batch(env, nullptr, (jlong) db, 1 << 30,
+            batch.bytes.size(), batch.buffer(jni)));
+    EXPECT_EQ("Malformed write batch", jni.thrown());
+}
+
+TEST_F(DatabaseTest, WriteBatchNeedsADirectBuffer) {
+    open();
+    EXPECT_EQ(nullptr, Java_io_pmem_pmemkv_Database_database_1write_1batch(env, nullptr, (jlong) db, 1, 16,
+            jni.buffer(nullptr, -1)));
+    EXPECT_EQ("Invalid ByteBuffer", jni.thrown());
+}
+
+TEST_F(DatabaseTest, GetManyFillsTheEntryTable) {
+    open();
+    put("a", "1");
+    put("big", "0123456789");
+    put("empty", "");
+    Batch keys;
+    keys.key("a").key("missing").key("big").key("empty");
+    std::string values(4 * GET_MANY_ENTRY_BYTES + 4, '\0');
+    const jint used = Java_io_pmem_pmemkv_Database_database_1get_1many_1buffer(env, nullptr, (jlong) db, 4,
+            keys.bytes.size(), keys.buffer(jni), values.size(), jni.buffer(&values[0], values.size()));
+    EXPECT_EQ("", jni.thrown());
+    EXPECT_EQ((jint) (4 * GET_MANY_ENTRY_BYTES + 1), used);
+
+    auto entry = [&](int i, int field) {
+        return read_int32(&values[i * GET_MANY_ENTRY_BYTES + field * sizeof(int32_t)]);
+    };
+    EXPECT_EQ(PMEMKV_STATUS_OK, entry(0, 0));
+    EXPECT_EQ(1, entry(0, 1));
+    EXPECT_EQ("1", values.substr(entry(0, 2), 1));
+    EXPECT_EQ(PMEMKV_STATUS_NOT_FOUND, entry(1, 0));
+    EXPECT_EQ(0, entry(1, 1));
+    // the value which does not fit reports its length, the next key still succeeds
+    EXPECT_EQ(GET_MANY_STATUS_TOO_SMALL, entry(2, 0));
+    EXPECT_EQ(10, entry(2, 1));
+    EXPECT_EQ(PMEMKV_STATUS_OK, entry(3, 0));
+    EXPECT_EQ(0, entry(3, 1));
+}
+
+TEST_F(DatabaseTest, MalformedGetManyIsRejected) {
+    open();
+    put("a", "1");
+    std::string values(2 * GET_MANY_ENTRY_BYTES, '\0');
+    auto get_many = [&](jint count, Batch& keys, jint keysbytes, jint valuesbytes) {
+        return Java_io_pmem_pmemkv_Database_database_1get_1many_1buffer(env, nullptr, (jlong) db, count,
+                keysbytes, keys.buffer(jni), valuesbytes, jni.buffer(&values[0], values.size()));
+    };
+
+    Batch keys;
+    keys.key("a").key("b");
+    // a key length running past the batch, and more keys than the batch holds
+    EXPECT_EQ(0, get_many(2, keys, keys.bytes.size() - 1, values.size()));
+    EXPECT_EQ("Malformed key batch", jni.thrown());
+    Batch one;
+    one.key("a");
+    EXPECT_EQ(0, get_many(2, one, one.bytes.size(), values.size()));
+    EXPECT_EQ("Malformed key batch", jni.thrown());
+    EXPECT_EQ(0, get_many(2, keys, keys.bytes.size() + 1, values.size()));
+    EXPECT_EQ("Malformed key batch", jni.thrown());
+
+    Batch negative;
+    negative.int32(-1);
+    EXPECT_EQ(0, get_many(1, negative, negative.bytes.size(), values.size()));
+    EXPECT_EQ("Malformed key batch", jni.thrown());
+
+    // the entry table must fit, and the sizes must lie within the buffers
+    EXPECT_EQ(0, get_many(2, keys, keys.bytes.size(), values.size() - 1));
+    EXPECT_EQ("ByteBuffer is too small", jni.thrown());
+    EXPECT_EQ(0, get_many(2, keys, keys.bytes.size(), values.size() + 1));
+    EXPECT_EQ("ByteBuffer is too small", jni.thrown());
+    EXPECT_EQ(0, get_many(-1, keys, keys.bytes.size(), values.size()));
+    EXPECT_EQ("ByteBuffer is too small", jni.thrown());
+}
+
+class BulkLoadTest : public DatabaseTest {
+  protected:
+    jlong session = 0;
+
+    void SetUp() override {
+        open();
+        session = Java_io_pmem_pmemkv_Database_database_1bulk_1load_1begin(env, nullptr, (jlong) db);
+    }
+
+    /* Queues the records packed in 'batch' as one chunk. */
+    void chunk(Batch& batch) {
+        Java_io_pmem_pmemkv_Database_database_1bulk_1load_1chunk(env, nullptr, session, batch.bytes.size(),
+                batch.buffer(jni));
+    }
+
+    static Batch& record(Batch& batch, const std::string& key, const std::string& value) {
+        return batch.int32(key.size()).int32(value.size()), batch.bytes += key + value, batch;
+    }
+
+    /* Finishes the session and returns its stats. */
+    std::vector<jlong> finish() {
+        const auto stats = Java_io_pmem_pmemkv_Database_database_1bulk_1load_1finish(env, nullptr, session);
+        EXPECT_NE(nullptr, stats) << jni.thrown();
+        return stats != nullptr ? FakeJni::values(stats) : std::vector<jlong>();
+    }
+};
+
+TEST_F(BulkLoadTest, InOrderChunksAreApplied) {
+    for (int c = 0; c < 4; c++) {
+        Batch batch;
+        for (int i = 0; i < 25; i++) record(batch, numbered_key(c * 25 + i), "v");
+        chunk(batch);
+        ASSERT_EQ("", jni.thrown());
+    }
+    const auto stats = finish();
+    ASSERT_EQ((size_t) BULK_LOAD_STATS, stats.size());
+    EXPECT_EQ(100, stats[0]);
+    EXPECT_EQ(100 * 7, stats[1]);
+    EXPECT_EQ(0, stats[2]);
+    EXPECT_EQ(4, stats[3]);
+    for (int i = 0; i < 100; i++) EXPECT_EQ("v", get(numbered_key(i)));
+}
+
+TEST_F(BulkLoadTest, OutOfOrderRecordsAreRejected) {
+    Batch first, second;
+    record(record(first, "b", "1"), "d", "2");
+    // "c" goes backwards across the chunk boundary, "d" repeats
+    record(record(record(second, "c", "3"), "d", "4"), "e", "5");
+    chunk(first);
+    chunk(second);
+    const auto stats = finish();
+    ASSERT_EQ((size_t) BULK_LOAD_STATS, stats.size());
+    EXPECT_EQ(3, stats[0]);
+    EXPECT_EQ(2, stats[2]);
+    EXPECT_EQ("<missing>", get("c"));
+    EXPECT_EQ("2", get("d"));
+    EXPECT_EQ("5", get("e"));
+}
+
+TEST_F(BulkLoadTest, MalformedChunksAreRejectedWhole) {
+    Batch batch;
+    record(record(batch, "a", "1"), "b", "2");
+    const jint truncated = batch.bytes.size() - 1;
+    Java_io_pmem_pmemkv_Database_database_1bulk_1load_1chunk(env, nullptr, session, truncated, batch.buffer(jni));
+    EXPECT_EQ("Malformed bulk load chunk", jni.thrown());
+    Java_io_pmem_pmemkv_Database_database_1bulk_1load_1chunk(env, nullptr, session, batch.bytes.size() + 1,
+            batch.buffer(jni));
+    EXPECT_EQ("ByteBuffer is too small", jni.thrown());
+    Java_io_pmem_pmemkv_Database_database_1bulk_1load_1chunk(env, nullptr, session, 8, jni.buffer(nullptr, -1));
+    EXPECT_EQ("Invalid ByteBuffer", jni.thrown());
+
+    Batch negative;
+    negative.int32(-1).int32(0);
+    chunk(negative);
+    EXPECT_EQ("Malformed bulk load chunk", jni.thrown());
+
+    const auto stats = finish();
+    ASSERT_EQ((size_t) BULK_LOAD_STATS, stats.size());
+    EXPECT_EQ(0, stats[0]);
+    EXPECT_EQ(0, stats[3]);
+    EXPECT_EQ("<missing>", get("a"));
+}
+
+class BatchScanTest : public DatabaseTest {
+  protected:
+    std::vector<char> batch = std::vector<char>(64);
+    std::vector<std::string> keys;
+    int calls = 0;
+
+    void SetUp() override {
+        open();
+        for (int i = 0; i < 10; i++) put(numbered_key(i), "v" + std::to_string(i));
+    }
+
+    /* A callback collecting the keys of every batch it is handed. */
+    jobject collector() {
+        return jni.callback([this](jint count, jint bytes) {
+            calls++;
+            const char* record = batch.data();
+            for (jint i = 0; i < count; i++) {
+                const auto keybytes = read_int32(record);
+                keys.emplace_back(record + 2 * sizeof(int32_t), keybytes);
+                record += 2 * sizeof(int32_t) + keybytes + read_int32(record + sizeof(int32_t));
+            }
+            EXPECT_EQ(bytes, record - batch.data());
+        });
+    }
+};
+
+TEST_F(BatchScanTest, RecordsArePackedIntoBatches) {
+    // each record is 8 + 6 + 2 bytes, so four fit in a batch
+    Java_io_pmem_pmemkv_Database_database_1get_1all_1batch(env, nullptr, (jlong) db, batch.size(),
+            jni.buffer(batch.data(), batch.size()), collector());
+    ASSERT_EQ("", jni.thrown());
+    EXPECT_EQ(3, calls);
+    ASSERT_EQ(10u, keys.size());
+    for (int i = 0; i < 10; i++) EXPECT_EQ(numbered_key(i), keys[i]);
+
+    keys.clear();
+    auto key = numbered_key(6);
+    Java_io_pmem_pmemkv_Database_database_1get_1above_1batch_1limit(env, nullptr, (jlong) db, key.size(),
+            jni.buffer(&key[0], key.size()), batch.size(), jni.buffer(batch.data(), batch.size()), 2, collector());
+    ASSERT_EQ("", jni.thrown());
+    EXPECT_EQ((std::vector<std::string>{numbered_key(7), numbered_key(8)}), keys);
+}
+
+TEST_F(BatchScanTest, InvalidBuffersAreRejected) {
+    const auto buffer = jni.buffer(batch.data(), batch.size());
+    Java_io_pmem_pmemkv_Database_database_1get_1all_1batch(env, nullptr, (jlong) db, batch.size() + 1, buffer,
+            collector());
+    EXPECT_EQ("ByteBuffer is too small", jni.thrown());
+    Java_io_pmem_pmemkv_Database_database_1get_1all_1batch(env, nullptr, (jlong) db, -1, buffer, collector());
+    EXPECT_EQ("Invalid ByteBuffer", jni.thrown());
+    auto key = numbered_key(0);
+    Java_io_pmem_pmemkv_Database_database_1get_1below_1batch(env, nullptr, (jlong) db, key.size(),
+            jni.buffer(&key[0], key.size()), 16, jni.buffer(nullptr, -1), collector());
+    EXPECT_EQ("Invalid ByteBuffer", jni.thrown());
+    EXPECT_EQ(0, calls);
+
+    // a record larger than the whole batch
+    Java_io_pmem_pmemkv_Database_database_1get_1all_1batch(env, nullptr, (jlong) db, 8, buffer, collector());
+    EXPECT_EQ("ByteBuffer is too small", jni.thrown());
+}
+
+class ParallelScanTest : public DatabaseTest {
+  protected:
+    std::vector<char> batches[2] = {std::vector<char>(256), std::vector<char>(256)};
+    std::vector<std::string> keys[2];
+    std::string key1 = "k", key2 = "l";
+
+    void SetUp() override {
+        open();
+        for (int i = 0; i < 100; i++) put(numbered_key(i), "v");
+    }
+
+    /* Collects the keys of partition 'i', which only its own thread touches. */
+    jobject collector(int i) {
+        return jni.callback([this, i](jint count, jint) {
+            const char* record = batches[i].data();
+            for (jint r = 0; r < count; r++) {
+                const auto keybytes = read_int32(record);
+                keys[i].emplace_back(record + 2 * sizeof(int32_t), keybytes);
+                record += 2 * sizeof(int32_t) + keybytes + read_int32(record + sizeof(int32_t));
+            }
+        });
+    }
+
+    void scan(jobjectArray buffers, jobjectArray callbacks) {
+        Java_io_pmem_pmemkv_Database_database_1get_1between_1parallel(env, nullptr, (jlong) db,
+                key1.size(), jni.buffer(&key1[0], key1.size()), key2.size(), jni.buffer(&key2[0], key2.size()),
+                buffers, callbacks);
+    }
+};
+
+TEST_F(ParallelScanTest, PartitionsCoverTheRange) {
+    scan(jni.objects({jni.buffer(batches[0].data(), 256), jni.buffer(batches[1].data(), 256)}),
+            jni.objects({collector(0), collector(1)}));
+    ASSERT_EQ("", jni.thrown());
+    EXPECT_FALSE(keys[0].empty());
+    std::vector<std::string> all(keys[0]);
+    all.insert(all.end(), keys[1].begin(), keys[1].end());
+    ASSERT_EQ(100u, all.size());
+    for (int i = 0; i < 100; i++) EXPECT_EQ(numbered_key(i), all[i]);
+}
+
+TEST_F(ParallelScanTest, InvalidPartitionsFailBeforeScanning) {
+    scan(jni.objects({jni.buffer(batches[0].data(), 256), jni.buffer(nullptr, -1)}),
+            jni.objects({collector(0), collector(1)}));
+    EXPECT_EQ("Invalid ByteBuffer", jni.thrown());
+    scan(jni.objects({jni.buffer(batches[0].data(), 256), jni.buffer(batches[1].data(), 256)}),
+            jni.objects({collector(0), nullptr}));
+    EXPECT_EQ("Invalid partitions", jni.thrown());
+    scan(jni.objects({jni.buffer(batches[0].data(), 256)}), jni.objects({collector(0), collector(1)}));
+    EXPECT_EQ("Invalid partitions", jni.thrown());
+    EXPECT_TRUE(keys[0].empty());
+    EXPECT_TRUE(keys[1].empty());
+}
+
+class AsyncTest : public DatabaseTest {
+  protected:
+    jlong pool = 0;
+    std::vector<char> value = std::vector<char>(16);
+
+    void SetUp() override {
+        open();
+        exception_class = &jni.cls;
+        pool = Java_io_pmem_pmemkv_Database_database_1async_1pool_1new(env, nullptr, 1, 4);
+        ASSERT_NE(0, pool) << jni.thrown();
+    }
+
+    void TearDown() override {
+        if (pool != 0) Java_io_pmem_pmemkv_Database_database_1async_1pool_1delete(env, nullptr, pool);
+        // both point into this test's FakeJni
+        exception_class = nullptr;
+        async_methods = {};
+    }
+
+    jobject key(const std::string& key) {
+        keys.push_back(key);
+        return jni.buffer(&keys.back()[0], key.size());
+    }
+
+    static std::string wait(jobject future) {
+        return static_cast<FakeFuture*>(future)->wait();
+    }
+
+    std::list<std::string> keys;
+};
+
+TEST_F(AsyncTest, OperationsCompleteTheirFutures) {
+    std::string data = "value";
+    auto future = jni.future();
+    Java_io_pmem_pmemkv_Database_database_1async_1put_1buffer(env, nullptr, pool, (jlong) db, 3, key("key"),
+            data.size(), jni.buffer(&data[0], data.size()), future);
+    ASSERT_EQ("", jni.thrown());
+    EXPECT_EQ("null", wait(future));
+
+    future = jni.future();
+    Java_io_pmem_pmemkv_Database_database_1async_1get_1buffer(env, nullptr, pool, (jlong) db, 3, key("key"),
+            value.size(), jni.buffer(value.data(), value.size()), future);
+    EXPECT_EQ("5", wait(future));
+    EXPECT_EQ("value", std::string(value.data(), 5));
+
+    future = jni.future();
+    Java_io_pmem_pmemkv_Database_database_1async_1get_1buffer(env, nullptr, pool, (jlong) db, 7, key("missing"),
+            value.size(), jni.buffer(value.data(), value.size()), future);
+    EXPECT_EQ("null", wait(future));
+
+    future = jni.future();
+    Java_io_pmem_pmemkv_Database_database_1async_1remove_1buffer(env, nullptr, pool, (jlong) db, 3, key("key"),
+            future);
+    EXPECT_EQ("1", wait(future));
+    EXPECT_EQ("<missing>", get("key"));
+
+    // a value longer than the buffer fails the future, not the call
+    put("long", std::string(100, 'x'));
+    future = jni.future();
+    Java_io_pmem_pmemkv_Database_database_1async_1get_1buffer(env, nullptr, pool, (jlong) db, 4, key("long"),
+            value.size(), jni.buffer(value.data(), value.size()), future);
+    EXPECT_EQ("exception: ByteBuffer is too small", wait(future));
+}
+
+TEST_F(AsyncTest, InvalidBuffersAreRejectedOnSubmit) {
+    const auto future = jni.future();
+    Java_io_pmem_pmemkv_Database_database_1async_1get_1buffer(env, nullptr, pool, (jlong) db, 3, key("key"),
+            value.size() + 1, jni.buffer(value.data(), value.size()), future);
+    EXPECT_EQ("ByteBuffer is too small", jni.thrown());
+    Java_io_pmem_pmemkv_Database_database_1async_1put_1buffer(env, nullptr, pool, (jlong) db, 3,
+            jni.buffer(nullptr, -1), 1, jni.buffer(value.data(), value.size()), future);
+    EXPECT_EQ("Invalid ByteBuffer", jni.thrown());
+    Java_io_pmem_pmemkv_Database_database_1async_1remove_1buffer(env, nullptr, pool, (jlong) db, 4, key("key"),
+            future);
+    EXPECT_EQ("ByteBuffer is too small", jni.thrown());
+    Java_io_pmem_pmemkv_Database_database_1async_1get_1all_1batch(env, nullptr, pool, (jlong) db, 16,
+            jni.buffer(nullptr, -1), jni.callback([](jint, jint) {}), future);
+    EXPECT_EQ("Invalid ByteBuffer", jni.thrown());
+    EXPECT_FALSE(static_cast<FakeFuture*>(future)->done);
+}
+
+TEST_F(AsyncTest, PoolCannotBeStoppedFromItsWorker) {
+    put("key", "value");
+    std::string stopped;
+    const auto callback = jni.callback([&](jint, jint) {
+        JNIEnv* worker;
+        jni.vm.vm.GetEnv((void**) &worker, JNI_VERSION_1_6);
+        Java_io_pmem_pmemkv_Database_database_1async_1pool_1delete(worker, nullptr, pool);
+        stopped = FakeJni::fake(worker)->thrown();
+    });
+    const auto future = jni.future();
+    Java_io_pmem_pmemkv_Database_database_1async_1get_1all_1batch(env, nullptr, pool, (jlong) db, value.size(),
+            jni.buffer(value.data(), value.size()), callback, future);
+    EXPECT_EQ("null", wait(future));
+    EXPECT_EQ("Async pool cannot be stopped from its own worker", stopped);
+}
+
+/* Gives the calling thread, attached to 'vm', a scratch buffer of 'bytes'. */
+static void reserve_scratch(JavaVM* vm, size_t bytes) {
+    JNIEnv* env;
+    ASSERT_EQ(JNI_OK, vm->AttachCurrentThread((void**) &env, nullptr));
+    ScratchScope scope;
+    ASSERT_TRUE(scratch_reserve(env, scope.level->key, bytes));
+}
+
+TEST_F(DatabaseTest, StopReleasesTheScratchOfEveryThread) {
+    open();
+    const auto before = FakeJni::global_refs.load();
+
+    // an idle thread keeps its arena until the database is stopped
+    std::mutex lock;
+    std::condition_variable cond;
+    int stage = 0;
+    std::thread idle([&] {
+        reserve_scratch(&jni.vm.vm, 100);
+        std::unique_lock<std::mutex> guard(lock);
+        stage = 1;
+        cond.notify_all();
+        cond.wait(guard, [&] { return stage == 2; });
+    });
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        cond.wait(guard, [&] { return stage == 1; });
+    }
+    // a thread exiting detached (no JavaVM here) leaves its buffer behind
+    std::thread(reserve_scratch, &jni.vm.vm, 100).join();
+    EXPECT_EQ(before + 2, FakeJni::global_refs.load());
+
+    close();
+    EXPECT_EQ(before, FakeJni::global_refs.load());
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stage = 2;
+    }
+    cond.notify_all();
+    idle.join();
+    EXPECT_EQ(before, FakeJni::global_refs.load());
+}
+
+TEST_F(DatabaseTest, GetIntoReportsTheValueLength) {
+    open();
+    put("key", "value");
+    const auto dest = jni.array(std::string(8, '-'));
+    EXPECT_EQ(5, Java_io_pmem_pmemkv_Database_database_1get_1into_1bytes(env, nullptr, (jlong) db,
+            jni.array("key"), dest, 2));
+    EXPECT_EQ("--value-", FakeJni::value(dest));
+    EXPECT_EQ(-5, Java_io_pmem_pmemkv_Database_database_1get_1into_1bytes(env, nullptr, (jlong) db,
+            jni.array("key"), dest, 4));
+    EXPECT_EQ(GET_INTO_NOT_FOUND, Java_io_pmem_pmemkv_Database_database_1get_1into_1bytes(env, nullptr, (jlong) db,
+            jni.array("missing"), dest, 0));
+    ASSERT_EQ("", jni.thrown());
+
+    // a length which cannot be negated into an int is not reported
+    ContextGetInto cxt = {env, dest, 0, 8, GET_INTO_NOT_FOUND};
+    CALLBACK_GET_INTO(nullptr, (size_t) INT32_MAX + 1, &cxt);
+    EXPECT_EQ(0, cxt.result);
+    EXPECT_EQ("Value is too large for a Java array", jni.thrown());
+}
+
+/* The UTF-16 units decode_utf8 produces for 'utf8'. */
+static std::vector<jchar> decoded(const std::string& utf8) {
+    std::vector<jchar> out(utf8.size());
+    out.resize(decode_utf8(utf8.data(), utf8.size(), out.data()));
+    return out;
+}
+
+TEST(StringTest, DecodesValidUtf8) {
+    EXPECT_EQ((std::vector<jchar>{'a', 0, 'b'}), decoded(std::string("a\0b", 3)));
+    EXPECT_EQ((std::vector<jchar>{0xE9, 0x20AC}), decoded("\xC3\xA9\xE2\x82\xAC"));
+    // 4-byte sequences become surrogate pairs
+    EXPECT_EQ((std::vector<jchar>{0xD83D, 0xDE00, 'x'}), decoded("\xF0\x9F\x98\x80x"));
+    EXPECT_EQ((std::vector<jchar>{0xDBFF, 0xDFFF}), decoded("\xF4\x8F\xBF\xBF"));
+}
+
+TEST(StringTest, MalformedUtf8IsReplaced) {
+    const jchar bad = 0xFFFD;
+    // stray continuation byte and invalid lead bytes
+    EXPECT_EQ((std::vector<jchar>{bad, 'a', bad, bad}), decoded("\x80" "a\xFE\xFF"));
+    // truncated sequences, at the end and before another character
+    EXPECT_EQ((std::vector<jchar>{'a', bad}), decoded("a\xE2\x82"));
+    EXPECT_EQ((std::vector<jchar>{bad, 'b'}), decoded("\xF0\x9F" "b"));
+    // overlong encodings
+    EXPECT_EQ((std::vector<jchar>{bad, bad}), decoded("\xC0\xAF\xE0\x80\xAF"));
+    // encoded surrogates and code points above U+10FFFF
+    EXPECT_EQ((std::vector<jchar>{bad, 'x'}), decoded("\xED\xA0\x80x"));
+    EXPECT_EQ((std::vector<jchar>{bad}), decoded("\xF4\x90\x80\x80"));
+}
+
+TEST(StringTest, OversizedInputIsRejected) {
+    FakeJni jni;
+    EXPECT_EQ(nullptr, new_string(&jni.env, "", (size_t) INT32_MAX + 1));
+    EXPECT_EQ("Value is too large for a Java string", jni.thrown());
+}